@@ -0,0 +1,110 @@
+#include "data/TextFrameParser.h"
+#include "data/BinaryFrameReader.h"
+#include "data/CompressedFrameReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+// Converts text particle files to the binary or, for an output ending in .pcmp, the compressed frame format
+// without starting the simulation or MPI.
+// usage: ConvertFrames <input.ptcl> [<output.pfrm|output.pcmp>] [<threads>] [<tolerance>]
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cout << "usage: ConvertFrames <input.ptcl> [<output.pfrm|output.pcmp>] [<threads>] [<tolerance>]" << std::endl;
+		return 1;
+	}
+
+	std::string input_path = argv[1];
+	std::string output_path;
+	if (argc > 2) {
+		output_path = argv[2];
+	}
+	else {
+		size_t extension_position = input_path.find_last_of('.');
+		output_path = input_path.substr(0, (extension_position == std::string::npos) ? input_path.size() : extension_position) + ".pfrm";
+	}
+	int thread_count = (argc > 3) ? std::atoi(argv[3]) : 0;
+	double tolerance = (argc > 4) ? std::atof(argv[4]) : FRAME_CODEC_TOLERANCE;
+	bool is_compressed = output_path.size() >= 5 && output_path.compare(output_path.size() - 5, 5, ".pcmp") == 0;
+	if (is_compressed && !(tolerance > 0.0 && tolerance < 0.5)) {
+		std::cout << "The tolerance has to lie between 0 and 0.5." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Converting \"" << input_path << "\" to \"" << output_path << "\"" << std::endl;
+	auto start_time = std::chrono::steady_clock::now();
+	bool is_converted = is_compressed ? TextFrameParser::convertToCompressed(input_path, output_path, tolerance, thread_count)
+		: TextFrameParser::convertToBinary(input_path, output_path, thread_count);
+	if (!is_converted) {
+		std::cout << "Conversion failed." << std::endl;
+		return 1;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	MappedFile input_file;
+	double megabytes = input_file.open(input_path) ? input_file.getSize() / 1048576.0 : 0.0;
+
+	if (!is_compressed) {
+		// report what was written and how fast the text was read
+		BinaryFrameReader reader;
+		if (!reader.open(output_path)) {
+			return 1;
+		}
+		long long particle_count = 0;
+		for (size_t i = 0; i < reader.getFrameCount(); i++) {
+			particle_count += reader.getParticleCount(i);
+		}
+		std::cout << reader.getFrameCount() << " frames with " << particle_count << " particles converted in " << seconds << " s ("
+			<< megabytes / seconds << " MiB/s of text)." << std::endl;
+		return 0;
+	}
+
+	// the writer reported the encode throughput, decode every frame again for the decode throughput and the largest error
+	CompressedFrameReader reader;
+	TextFrameParser parser;
+	if (!reader.open(output_path) || !parser.open(input_path, thread_count)) {
+		return 1;
+	}
+	long long particle_count = 0;
+	double largest_error = 0.0;
+	double decode_seconds = 0.0;
+	vector<SphParticle> decoded_frame;
+	vector<SphParticle> text_frame;
+	for (size_t i = 0; i < reader.getFrameCount(); i++) {
+		auto decode_start_time = std::chrono::steady_clock::now();
+		reader.readFrame(i, decoded_frame);
+		decode_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - decode_start_time).count();
+		particle_count += static_cast<long long>(decoded_frame.size());
+
+		// the decoded particles come in another order, so the positions are compared as sorted lists per axis
+		parser.parseFrame(i, text_frame);
+		if (text_frame.size() != decoded_frame.size()) {
+			std::cout << "Frame " << i << " has " << decoded_frame.size() << " instead of " << text_frame.size() << " particles." << std::endl;
+			return 1;
+		}
+		for (int axis = 0; axis < 3; axis++) {
+			vector<double> decoded_values(decoded_frame.size());
+			vector<double> text_values(text_frame.size());
+			for (size_t k = 0; k < text_frame.size(); k++) {
+				decoded_values[k] = (axis == 0) ? decoded_frame[k].position.x : (axis == 1) ? decoded_frame[k].position.y : decoded_frame[k].position.z;
+				text_values[k] = (axis == 0) ? text_frame[k].position.x : (axis == 1) ? text_frame[k].position.y : text_frame[k].position.z;
+			}
+			std::sort(decoded_values.begin(), decoded_values.end());
+			std::sort(text_values.begin(), text_values.end());
+			for (size_t k = 0; k < text_values.size(); k++) {
+				largest_error = std::max(largest_error, std::fabs(decoded_values[k] - text_values[k]));
+			}
+		}
+	}
+
+	double raw_megabytes = particle_count * PARTICLE_RECORD_SIZE * sizeof(double) / 1048576.0;
+	double compressed_megabytes = reader.getCompressedSize() / 1048576.0;
+	std::cout << reader.getFrameCount() << " frames with " << particle_count << " particles compressed in " << seconds << " s ("
+		<< megabytes / seconds << " MiB/s of text)." << std::endl
+		<< "Compression " << raw_megabytes / compressed_megabytes << " : 1 against the binary frame format, "
+		<< megabytes / compressed_megabytes << " : 1 against the text." << std::endl
+		<< "Decoded at " << raw_megabytes / std::max(decode_seconds, 1e-9) << " MiB/s of particle records." << std::endl
+		<< "Largest difference of the sorted coordinates " << largest_error << " at tolerance " << tolerance << "." << std::endl;
+	return 0;
+}
@@ -1,11 +1,36 @@
 #include "cui/CUI.h"
+#include <cstring>
 
 int main(int argc, char** argv) {
-	MPI_Init(&argc, &argv);
+	// the communication progress thread calls MPI concurrently to the simulation
+	bool wants_progress_thread = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-progressthread") == 0) {
+			wants_progress_thread = true;
+		}
+	}
+
+	if (wants_progress_thread) {
+		int provided;
+		MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+		SimulationUtilities::use_progress_thread = (provided == MPI_THREAD_MULTIPLE);
+	}
+	else {
+		MPI_Init(&argc, &argv);
+	}
 
 	int mpi_rank;
 	MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
 
+	if (mpi_rank == 0 && wants_progress_thread) {
+		if (SimulationUtilities::use_progress_thread) {
+			std::cout << "Communication progress thread enabled." << std::endl;
+		}
+		else {
+			std::cout << "MPI_THREAD_MULTIPLE is not supported, communication progress thread disabled." << std::endl;
+		}
+	}
+
 	// generate slave_comm and slave_comm_size for simulation
 	int color = 1337;
 	if (mpi_rank == 0) {
@@ -16,6 +41,11 @@ int main(int argc, char** argv) {
 		MPI_Comm_size(slave_comm, &slave_comm_size);
 	}
 
+#ifdef SIGUSR1
+	// kill -USR1 writes a checkpoint after the current timestep
+	std::signal(SIGUSR1, SphManager::requestCheckpoint);
+#endif
+
 	// start cui and command handling
 	CommandHandler command_handler = CommandHandler(mpi_rank);
 	if (mpi_rank == 0) {
@@ -141,6 +141,34 @@ void CUI::cleanAndExecuteCommand(bool is_config_execution, bool& exit_program) {
 		}
 		printInputMessage();
 	}
+	else if (command == "set") {
+		if (cleanSetOption()) {
+			current_command.setCommand(CUICommand::SET_OPTION);
+			command_handler.handleCUICommand(current_command);
+		}
+		printInputMessage();
+	}
+	else if (command == "output") {
+		if (cleanOutput()) {
+			current_command.setCommand(CUICommand::SET_OUTPUT);
+			command_handler.handleCUICommand(current_command);
+		}
+		printInputMessage();
+	}
+	else if (command == "convert") {
+		if (cleanConvert()) {
+			current_command.setCommand(CUICommand::CONVERT_FRAMES);
+			command_handler.handleCUICommand(current_command);
+		}
+		printInputMessage();
+	}
+	else if (command == "restart") {
+		if (cleanRestart()) {
+			current_command.setCommand(CUICommand::RESTART);
+			command_handler.handleCUICommand(current_command);
+		}
+		printInputMessage();
+	}
 	else if (command == "loadconfig")
 	{
 		loadConfig();
@@ -206,6 +234,7 @@ void CUI::showHelp() {
 		<< "   -v | followed by 3 numbers x y z, who stand for the coordinates of a point in 3D space" << endl
 		<< "   -h | for addsink which determines the sink height or for render sets the height of the output image" << endl << endl
 		<< "   -w | for render sets the width of the output image" << endl << endl
+		<< "   -o | followed by the name of a simulation option and its value" << endl << endl
 
 		<< "Commands:" << endl
 		<< "   print" << endl
@@ -238,6 +267,37 @@ void CUI::showHelp() {
 		<< "   render [-v] [-w -h]" << endl
 		<< "      Start the rendering process. The camera position can be set with '-v' parameter. Camera is looking roughly towards (0,0,0). -w and -h can be used to set the reolution of the output images." << endl << endl
 
+		<< "   set -o" << endl
+		<< "      Set a simulation option. Available options:" << endl
+		<< "      exchange twosided|onesided|persistent rim exchange with messages (default), with MPI windows or with persistent requests" << endl
+		<< "      blocksize <n>                each process owns blocks of n^3 neighbour search cells (default 1)" << endl
+		<< "      density summation|continuity sum up densities every step (default) or integrate them and sum up every " << DENSITY_REINITIALIZATION_INTERVAL << " steps" << endl
+		<< "      ghostlayer single|double     exchange densities every step (default) or a rim of 2 * Q_MAX and compute them locally" << endl
+		<< "      sharedmemory on|off          exchange with processes on the same node through shared memory (default off)" << endl
+		<< "      export master|mpiio          master writes sph.ptcl and vtk files (default) or all slaves write binary frames to sph.pbin with MPI-IO" << endl
+		<< "      exportqueue <n>              frames the export may fall behind before the simulation waits (default " << EXPORT_QUEUE_LENGTH << ")" << endl
+		<< "      frameformat text|binary|compressed master writes frames as text to sph.ptcl (default), binary to sph.pfrm or compressed to sph.pcmp" << endl
+		<< "      frametolerance <relative>    error of compressed frames relative to the bounding box of a frame (default " << FRAME_CODEC_TOLERANCE << ")" << endl
+		<< "      particleids on|off           text and binary frames carry the particle ids, compressed frames always do (default off)" << endl
+		<< "      vtkformat legacy|vtu         ascii legacy vtk files (default) or binary vtu pieces per process with pvtu and pvd files" << endl
+		<< "      halocodec on|off             send rim particles as ids and lossy quantised deltas, twosided only (default off)" << endl << endl
+
+		<< "   output -s [-i | -t] [-r] [-f] [-c]" << endl
+		<< "      Configure an output stream of the simulation. Available flags:" << endl
+		<< "      -s vtk|frames|statistics|checkpoint the stream: vtk or vtu files, frames in sph.ptcl for rendering, statistics.csv or sph.chkp" << endl
+		<< "      -i <n>                       write every n timesteps, 0 disables the stream (default 1, statistics and checkpoint 0)" << endl
+		<< "      -t <seconds>                 write every given simulated time instead of a number of timesteps" << endl
+		<< "      -r x1 y1 z1 x2 y2 z2 | off   only write particles inside the box between the two corners" << endl
+		<< "      -f norm,velocity,density,rank fields written to the vtk files (default all)" << endl
+		<< "      -c all|surface               vtk and frames: all particles (default) or the particles at the free surface and one per cell for the interior" << endl << endl
+
+		<< "   convert -p [-f]" << endl
+		<< "      Convert a frame file from text to the binary frame format (.pfrm) or back to text (.ptcl)." << endl
+		<< "      -f text|binary|compressed    target format, compressed (.pcmp) takes text or binary frame files and the frametolerance option" << endl << endl
+
+		<< "   restart -p" << endl
+		<< "      Load a checkpoint onto the slaves, the next simulation continues after its timestep. Any number of processes can load it." << endl << endl
+
 		<< "   help" << endl
 		<< "      Show help" << endl << endl
 
@@ -433,4 +493,122 @@ bool CUI::cleanRender()
 
 	return hasOnlyValidParameters;
 }
+
+bool CUI::cleanSetOption() {
+	bool hasOnlyValidParameters = true;
+
+	for (CUICommandParameter& parameter : current_command.getParameterList()) {
+		if (parameter.getParameterName() == "-o") {
+			std::string option = parameter.getValue();
+			if (option.find(' ') == std::string::npos) {
+				hasOnlyValidParameters = false;
+				std::cout << "'" << option << "' is missing a value" << std::endl;
+			}
+		}
+		else {
+			current_command.removeParameter(parameter);
+		}
+	}
+
+	if (!current_command.hasParameter("-o")) {
+		hasOnlyValidParameters = false;
+		std::cout << "Missing option parameter '-o'" << std::endl;
+	}
+
+	return hasOnlyValidParameters;
+}
+bool CUI::cleanOutput() {
+	bool hasOnlyValidParameters = true;
+
+	for (CUICommandParameter& parameter : current_command.getParameterList()) {
+		std::string value = parameter.getValue();
+		if (parameter.getParameterName() == "-s") {
+			if (value != "vtk" && value != "frames" && value != "statistics" && value != "checkpoint") {
+				hasOnlyValidParameters = false;
+				std::cout << "'" << value << "' is not an output stream" << std::endl;
+			}
+		}
+		else if (parameter.getParameterName() == "-i" || parameter.getParameterName() == "-t") {
+			if (value.empty() || value.find_first_not_of(",.0123456789") != std::string::npos) {
+				hasOnlyValidParameters = false;
+				std::cout << "'" << value << "' is not a number" << std::endl;
+			}
+		}
+		else if (parameter.getParameterName() == "-r") {
+			int spaces = 0;
+			for (char character : value) {
+				if (character == ' ') {
+					spaces++;
+				}
+			}
+
+			if (value != "off" && (value.find_first_not_of("+-,.0123456789 ") != std::string::npos || spaces != 5)) {
+				hasOnlyValidParameters = false;
+				std::cout << "'" << value << "' is not a valid region" << std::endl;
+			}
+		}
+		else if (parameter.getParameterName() == "-f") {
+			if (value.empty()) {
+				hasOnlyValidParameters = false;
+				std::cout << "Missing fields for parameter '-f'" << std::endl;
+			}
+		}
+		else if (parameter.getParameterName() == "-c") {
+			if (value != "all" && value != "surface") {
+				hasOnlyValidParameters = false;
+				std::cout << "'" << value << "' is not an output content" << std::endl;
+			}
+		}
+		else {
+			current_command.removeParameter(parameter);
+		}
+	}
+
+	if (!current_command.hasParameter("-s")) {
+		hasOnlyValidParameters = false;
+		std::cout << "Missing stream parameter '-s'" << std::endl;
+	}
+
+	return hasOnlyValidParameters;
+}
+bool CUI::cleanConvert() {
+	bool hasOnlyValidParameters = true;
+
+	for (CUICommandParameter& parameter : current_command.getParameterList()) {
+		if (parameter.getParameterName() == "-f") {
+			std::string value = parameter.getValue();
+			if (value != "text" && value != "binary" && value != "compressed") {
+				hasOnlyValidParameters = false;
+				std::cout << "'" << value << "' is not a frame format" << std::endl;
+			}
+		}
+		else if (parameter.getParameterName() != "-p") {
+			current_command.removeParameter(parameter);
+		}
+	}
+
+	if (!current_command.hasParameter("-p")) {
+		hasOnlyValidParameters = false;
+		std::cout << "Missing path parameter '-p'" << std::endl;
+	}
+
+	return hasOnlyValidParameters;
+}
+
+bool CUI::cleanRestart() {
+	bool hasOnlyValidParameters = true;
+
+	for (CUICommandParameter& parameter : current_command.getParameterList()) {
+		if (parameter.getParameterName() != "-p") {
+			current_command.removeParameter(parameter);
+		}
+	}
+
+	if (!current_command.hasParameter("-p")) {
+		hasOnlyValidParameters = false;
+		std::cout << "Missing path parameter '-p'" << std::endl;
+	}
+
+	return hasOnlyValidParameters;
+}
 /* -_-_-_Commands End_-_-_- */
@@ -37,4 +37,8 @@ class CUI {
 		bool cleanAddSink();
 		bool cleanSimulate();
 		bool cleanRender();
+		bool cleanSetOption();
+		bool cleanOutput();
+		bool cleanConvert();
+		bool cleanRestart();
 };
\ No newline at end of file
@@ -18,7 +18,11 @@ class CUICommand {
 			ADD_SOURCE,
 			ADD_SINK,
 			SIMULATE,
-			RENDER
+			RENDER,
+			SET_OPTION,
+			SET_OUTPUT,
+			CONVERT_FRAMES,
+			RESTART
 		};
 
 		CUICommand();
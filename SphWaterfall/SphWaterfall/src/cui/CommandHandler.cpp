@@ -194,9 +194,11 @@ void CommandHandler::executeCommand(CUICommand& cui_command) {
 			if (mpi_rank != 0) {
 				simulate(simulation_timesteps);
 			}
-			else {
+			else if (sph_manager.getExportMode() == SphManager::MASTER_EXPORT) {
 				createExport(simulation_timesteps);
 			}
+			// a restart only applies to the next simulation
+			sph_manager.setFirstTimestep(1);
 			MPI_Barrier(MPI_COMM_WORLD);
 
 			// console feedback
@@ -246,6 +248,25 @@ void CommandHandler::executeCommand(CUICommand& cui_command) {
 				cout << "Added sink." << endl;
 			}
 			break;
+		case CUICommand::SET_OPTION:
+			setOption(cui_command.getParameter(cui_command.getParameterIndex("-o")).getValue());
+			MPI_Barrier(MPI_COMM_WORLD);
+			break;
+		case CUICommand::CONVERT_FRAMES:
+			if (mpi_rank == 0) {
+				std::string target_format = cui_command.hasParameter("-f") ? cui_command.getParameter(cui_command.getParameterIndex("-f")).getValue() : "";
+				convertFrames(cui_command.getParameter(cui_command.getParameterIndex("-p")).getValue(), target_format);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+			break;
+		case CUICommand::SET_OUTPUT:
+			setOutput(cui_command);
+			MPI_Barrier(MPI_COMM_WORLD);
+			break;
+		case CUICommand::RESTART:
+			restart(cui_command.getParameter(cui_command.getParameterIndex("-p")).getValue());
+			MPI_Barrier(MPI_COMM_WORLD);
+			break;
 		default:
 			break;
 	}
@@ -300,40 +321,104 @@ void CommandHandler::generateParticles(Terrain& loaded_mesh, SphParticle::Partic
 }
 
 void CommandHandler::createExport(int simulation_timesteps) {
-	int current_timestep = 1;
-	unordered_map<int, vector<SphParticle>> export_map;
+	// frames are written on a background thread while the next ones are received
+	const OutputScheduler& output_scheduler = sph_manager.getOutputScheduler();
+	ParticleStreamWriter::Format frame_format = ParticleStreamWriter::TEXT_FORMAT;
+	if (sph_manager.getFrameFormat() == SphManager::BINARY_FRAMES) {
+		frame_format = ParticleStreamWriter::BINARY_FORMAT;
+	}
+	else if (sph_manager.getFrameFormat() == SphManager::COMPRESSED_FRAMES) {
+		frame_format = ParticleStreamWriter::COMPRESSED_FORMAT;
+	}
+	AsyncFrameWriter frame_writer(getFrameFileName(), frame_format, sph_manager.getFrameTolerance(), sph_manager.getFrameIds(), sph_manager.getVtkFormat() == SphManager::VTU_VTK,
+		output_scheduler, sph_manager.getFirstTimestep(), simulation_timesteps, sph_manager.getExportQueueLength());
 
 	int slave_comm_size;
 	MPI_Comm_size(MPI_COMM_WORLD, &slave_comm_size);
 	slave_comm_size--;
 
-	while (current_timestep <= simulation_timesteps) {
-		std::vector<SphParticle> all_particles_of_timestep;
-
-		std::vector<int> number_of_incoming_particles = std::vector<int>(slave_comm_size);
-		std::unordered_map<int, std::vector<SphParticle>> incoming_particles;
-
-		MPI_Barrier(MPI_COMM_WORLD);
-
-		for (int i = 0; i < slave_comm_size; i++) {
-			MPI_Recv(&number_of_incoming_particles[i], 1, MPI_INT, i + 1, EXPORT_PARTICLES_NUMBER_TAG, MPI_COMM_WORLD, MPI_STATUSES_IGNORE);
-			incoming_particles[i] = std::vector<SphParticle>(number_of_incoming_particles.at(i));
+	// the slaves only send on timesteps with a vtk file or frame due
+	std::vector<int> export_timesteps;
+	for (int timestep = sph_manager.getFirstTimestep(); timestep <= simulation_timesteps; timestep++) {
+		if (output_scheduler.isExportDue(timestep)) {
+			export_timesteps.push_back(timestep);
 		}
+	}
 
-		for (int i = 0; i < slave_comm_size; i++) {
-			if (number_of_incoming_particles.at(i) != 0) {
-				MPI_Recv(incoming_particles[i].data(), number_of_incoming_particles.at(i) * sizeof(SphParticle), MPI_BYTE, i + 1, EXPORT_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-				all_particles_of_timestep.insert(all_particles_of_timestep.end(), incoming_particles.at(i).begin(), incoming_particles.at(i).end());
+	// as many frames are received at once as the slaves may have in flight, so they never wait for the master
+	struct IncomingFrame {
+		int timestep;
+		std::vector<long long> counts;
+		std::vector<MPI_Request> count_requests;
+		std::vector<SphParticle> particles;
+		std::vector<MPI_Request> particle_requests;
+		bool is_receiving_particles;
+	};
+	std::deque<IncomingFrame> incoming_frames;
+	size_t next_frame = 0;
+	long long received_particles = 0;
+	double wait_seconds = 0.0;
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+	while (next_frame < export_timesteps.size() || !incoming_frames.empty()) {
+		while (next_frame < export_timesteps.size() && incoming_frames.size() < static_cast<size_t>(sph_manager.getExportQueueLength())) {
+			incoming_frames.emplace_back();
+			IncomingFrame& frame = incoming_frames.back();
+			frame.timestep = export_timesteps[next_frame++];
+			frame.counts.assign(slave_comm_size, 0);
+			frame.count_requests.resize(slave_comm_size);
+			frame.is_receiving_particles = false;
+			for (int i = 0; i < slave_comm_size; i++) {
+				MPI_Irecv(&frame.counts[i], 1, MPI_LONG_LONG, i + 1, EXPORT_PARTICLES_NUMBER_TAG, MPI_COMM_WORLD, &frame.count_requests[i]);
 			}
 		}
 
-		export_map[current_timestep] = all_particles_of_timestep;
-		ParticleIO::exportParticlesToVTK(all_particles_of_timestep, "vtk/particles", current_timestep, number_of_incoming_particles);
+		// the particles of every frame whose counts are complete are received at once, each slave into its own part.
+		// Messages of one slave don't overtake each other, so the receives have to be posted in the order of the frames
+		std::chrono::steady_clock::time_point wait_start_time = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < incoming_frames.size(); k++) {
+			IncomingFrame& frame = incoming_frames[k];
+			if (frame.is_receiving_particles) {
+				continue;
+			}
+			int has_counts = 1;
+			if (k == 0) {
+				MPI_Waitall(slave_comm_size, frame.count_requests.data(), MPI_STATUSES_IGNORE);
+			}
+			else {
+				MPI_Testall(slave_comm_size, frame.count_requests.data(), &has_counts, MPI_STATUSES_IGNORE);
+			}
+			if (!has_counts) {
+				break;
+			}
+
+			long long total_count = 0;
+			for (long long each_count : frame.counts) {
+				total_count += each_count;
+			}
+			frame.particles.resize(total_count);
+			long long offset = 0;
+			for (int i = 0; i < slave_comm_size; i++) {
+				if (frame.counts[i] != 0) {
+					SimulationUtilities::postParticleReceives(frame.particles.data() + offset, frame.counts[i], i + 1, EXPORT_TAG, MPI_COMM_WORLD, frame.particle_requests);
+					offset += frame.counts[i];
+				}
+			}
+			frame.is_receiving_particles = true;
+		}
 
-		current_timestep++;
+		IncomingFrame& frame = incoming_frames.front();
+		MPI_Waitall(static_cast<int>(frame.particle_requests.size()), frame.particle_requests.data(), MPI_STATUSES_IGNORE);
+		wait_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_start_time).count();
+		received_particles += static_cast<long long>(frame.particles.size());
+		frame_writer.push(frame.particles, frame.counts, frame.timestep);
+		incoming_frames.pop_front();
 	}
-	ParticleIO::exportParticles(export_map, "sph.ptcl");
+	frame_writer.finish();
 
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	std::cout << "Received " << export_timesteps.size() << " frames with " << received_particles << " particles in " << seconds << " s, "
+		<< wait_seconds << " s of it waiting for the slaves." << std::endl;
 	std::cout << "Done exporting" << std::endl;
 }
 
@@ -398,7 +483,7 @@ void CommandHandler::render(Terrain loaded_mesh, Terrain loaded_shutter, int shu
 
 	VisualizationManager::init(cameraPosition, width, height, mpi_rank);
 	//VisualizationManager::renderFrames("sph.ptcl");
-	VisualizationManager::renderFramesDistributed("sph.ptcl", mpi_rank);
+	VisualizationManager::renderFramesDistributed(getFrameFileName(), mpi_rank);
 
 	MPI_Barrier(MPI_COMM_WORLD);
 
@@ -428,3 +513,328 @@ void CommandHandler::addSink(std::string sink_height_string) {
 	sph_manager.setSink(sink_height);
 	std::cout << "Sink added at y=" << sink_height << std::endl;
 }
+
+void CommandHandler::setOption(std::string option_string) {
+	std::transform(option_string.begin(), option_string.end(), option_string.begin(), ::tolower);
+	std::istringstream option_stream(option_string);
+	std::string option_name, option_value;
+	option_stream >> option_name;
+	option_stream >> option_value;
+
+	bool is_valid = true;
+	if (option_name == "exchange") {
+		if (option_value == "twosided") {
+			sph_manager.setHaloExchangeMode(SphManager::TWO_SIDED);
+		}
+		else if (option_value == "onesided") {
+			sph_manager.setHaloExchangeMode(SphManager::ONE_SIDED);
+		}
+		else if (option_value == "persistent") {
+			sph_manager.setHaloExchangeMode(SphManager::PERSISTENT);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "blocksize") {
+		int cells_per_block = parseToInteger(option_value);
+		if (cells_per_block > 0) {
+			sph_manager.setBlockSize(cells_per_block);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "density") {
+		if (option_value == "summation") {
+			sph_manager.setDensityMode(SphManager::SUMMATION_DENSITY);
+		}
+		else if (option_value == "continuity") {
+			sph_manager.setDensityMode(SphManager::CONTINUITY_DENSITY);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "ghostlayer") {
+		if (option_value == "single") {
+			sph_manager.setDoubleGhostLayer(false);
+		}
+		else if (option_value == "double") {
+			sph_manager.setDoubleGhostLayer(true);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "sharedmemory") {
+		if (option_value == "on") {
+			sph_manager.setSharedMemoryExchange(true);
+		}
+		else if (option_value == "off") {
+			sph_manager.setSharedMemoryExchange(false);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "export") {
+		if (option_value == "master") {
+			sph_manager.setExportMode(SphManager::MASTER_EXPORT);
+		}
+		else if (option_value == "mpiio") {
+			sph_manager.setExportMode(SphManager::MPIIO_EXPORT);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "exportqueue") {
+		int queue_length = parseToInteger(option_value);
+		if (queue_length > 0) {
+			sph_manager.setExportQueueLength(queue_length);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "frameformat") {
+		if (option_value == "text") {
+			sph_manager.setFrameFormat(SphManager::TEXT_FRAMES);
+		}
+		else if (option_value == "binary") {
+			sph_manager.setFrameFormat(SphManager::BINARY_FRAMES);
+		}
+		else if (option_value == "compressed") {
+			sph_manager.setFrameFormat(SphManager::COMPRESSED_FRAMES);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "frametolerance") {
+		double frame_tolerance = parseToDouble(option_value);
+		if (frame_tolerance > 0.0 && frame_tolerance < 0.5) {
+			sph_manager.setFrameTolerance(frame_tolerance);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "particleids") {
+		if (option_value == "on") {
+			sph_manager.setFrameIds(true);
+		}
+		else if (option_value == "off") {
+			sph_manager.setFrameIds(false);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "vtkformat") {
+		if (option_value == "legacy") {
+			sph_manager.setVtkFormat(SphManager::LEGACY_VTK);
+		}
+		else if (option_value == "vtu") {
+			sph_manager.setVtkFormat(SphManager::VTU_VTK);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else if (option_name == "halocodec") {
+		if (option_value == "on") {
+			sph_manager.setHaloCodec(true);
+		}
+		else if (option_value == "off") {
+			sph_manager.setHaloCodec(false);
+		}
+		else {
+			is_valid = false;
+		}
+	}
+	else {
+		is_valid = false;
+	}
+
+	// console feedback
+	if (mpi_rank == 0) {
+		if (is_valid) {
+			cout << "Option " << option_name << " set to " << option_value << "." << endl;
+		}
+		else {
+			cout << "Unknown option or value '" << option_string << "'." << endl;
+		}
+	}
+}
+
+void CommandHandler::setOutput(CUICommand& cui_command) {
+	std::string stream_name = cui_command.getParameter(cui_command.getParameterIndex("-s")).getValue();
+	OutputScheduler::Stream stream;
+	if (stream_name == "vtk") {
+		stream = OutputScheduler::VTK_STREAM;
+	}
+	else if (stream_name == "frames") {
+		stream = OutputScheduler::FRAME_STREAM;
+	}
+	else if (stream_name == "checkpoint") {
+		stream = OutputScheduler::CHECKPOINT_STREAM;
+	}
+	else {
+		stream = OutputScheduler::STATISTICS_STREAM;
+	}
+	OutputScheduler& output_scheduler = sph_manager.getOutputScheduler();
+
+	bool is_valid = true;
+	if (cui_command.hasParameter("-i")) {
+		output_scheduler.setInterval(stream, parseToInteger(cui_command.getParameter(cui_command.getParameterIndex("-i")).getValue()));
+	}
+	else if (cui_command.hasParameter("-t")) {
+		double interval_time = parseToDouble(cui_command.getParameter(cui_command.getParameterIndex("-t")).getValue());
+		output_scheduler.setInterval(stream, std::max(1, static_cast<int>(round(interval_time / TIMESTEP_DURATION))));
+	}
+
+	if (cui_command.hasParameter("-r")) {
+		std::string region = cui_command.getParameter(cui_command.getParameterIndex("-r")).getValue();
+		if (region == "off") {
+			output_scheduler.clearRegion(stream);
+		}
+		else {
+			std::istringstream region_stream(region);
+			Vector3 region_min, region_max;
+			region_stream >> region_min.x >> region_min.y >> region_min.z >> region_max.x >> region_max.y >> region_max.z;
+			output_scheduler.setRegion(stream, region_min, region_max);
+		}
+	}
+
+	if (cui_command.hasParameter("-f")) {
+		std::string field_list = cui_command.getParameter(cui_command.getParameterIndex("-f")).getValue();
+		std::replace(field_list.begin(), field_list.end(), ',', ' ');
+		std::istringstream field_stream(field_list);
+		std::string field_name;
+		int fields = 0;
+		while (field_stream >> field_name) {
+			if (field_name == "norm") {
+				fields |= OutputScheduler::NORM_FIELD;
+			}
+			else if (field_name == "velocity") {
+				fields |= OutputScheduler::VELOCITY_FIELD;
+			}
+			else if (field_name == "density") {
+				fields |= OutputScheduler::DENSITY_FIELD;
+			}
+			else if (field_name == "rank") {
+				fields |= OutputScheduler::RANK_FIELD;
+			}
+			else {
+				is_valid = false;
+			}
+		}
+		if (is_valid) {
+			output_scheduler.setFields(stream, fields);
+		}
+	}
+
+	if (cui_command.hasParameter("-c")) {
+		bool is_surface = cui_command.getParameter(cui_command.getParameterIndex("-c")).getValue() == "surface";
+		output_scheduler.setContent(stream, is_surface ? OutputScheduler::SURFACE_PARTICLES : OutputScheduler::ALL_PARTICLES);
+	}
+
+	// console feedback
+	if (mpi_rank == 0) {
+		if (is_valid) {
+			cout << "Output " << stream_name << " set." << endl;
+		}
+		else {
+			cout << "Unknown fields '" << cui_command.getParameter(cui_command.getParameterIndex("-f")).getValue() << "'." << endl;
+		}
+	}
+}
+
+void CommandHandler::restart(std::string file_path) {
+	// every process reads the header, the master only needs the timestep and the renderers the shutter
+	CheckpointState state;
+	unsigned long long particle_count;
+	bool is_loaded = CheckpointReader::readState(file_path, state, particle_count);
+	if (is_loaded && mpi_rank != 0) {
+		is_loaded = sph_manager.restart(file_path);
+	}
+	else if (is_loaded) {
+		sph_manager.setFirstTimestep(static_cast<int>(state.timestep) + 1);
+	}
+	// the frames are numbered by their timestep, so the shutter switches at the same frame as before the checkpoint
+	if (is_loaded && state.shutter_timestep > 0) {
+		VisualizationManager::setSwitchFrame(static_cast<int>(state.shutter_timestep));
+	}
+
+	// console feedback
+	if (mpi_rank == 0) {
+		if (is_loaded) {
+			cout << "Restarted from timestep " << state.timestep << " with " << particle_count << " particles." << endl;
+		}
+		else {
+			cout << "Unable to load checkpoint '" << file_path << "'." << endl;
+		}
+	}
+}
+
+std::string CommandHandler::getFrameFileName() {
+	// the slaves write the binary frame format themselves
+	if (sph_manager.getExportMode() == SphManager::MPIIO_EXPORT) {
+		return "sph.pbin";
+	}
+	if (sph_manager.getFrameFormat() == SphManager::BINARY_FRAMES) {
+		return "sph.pfrm";
+	}
+	if (sph_manager.getFrameFormat() == SphManager::COMPRESSED_FRAMES) {
+		return "sph.pcmp";
+	}
+	return "sph.ptcl";
+}
+
+void CommandHandler::convertFrames(std::string file_path, std::string target_format) {
+	// without a target format the direction follows the content, the result gets the extension of the other format
+	bool is_binary = BinaryFrameReader::isBinaryFrameFile(file_path);
+	bool is_compressed = CompressedFrameReader::isCompressedFrameFile(file_path);
+	if (target_format.empty()) {
+		target_format = (is_binary || is_compressed) ? "text" : "binary";
+	}
+	if ((target_format == "text" && !is_binary && !is_compressed) || (target_format == "binary" && (is_binary || is_compressed))
+		|| (target_format == "compressed" && is_compressed)) {
+		std::cout << "\"" << file_path << "\" can't be converted to " << target_format << "." << std::endl;
+		return;
+	}
+
+	size_t extension_position = file_path.find_last_of('.');
+	std::string converted_path = file_path.substr(0, (extension_position == std::string::npos) ? file_path.size() : extension_position);
+	if (target_format == "text") {
+		converted_path += ".ptcl";
+	}
+	else if (target_format == "binary") {
+		converted_path += ".pfrm";
+	}
+	else {
+		converted_path += ".pcmp";
+	}
+
+	std::cout << "Converting \"" << file_path << "\" to \"" << converted_path << "\"" << std::endl;
+	bool is_converted;
+	if (target_format == "text") {
+		is_converted = ParticleIO::convertBinaryToText(file_path, converted_path);
+	}
+	else if (target_format == "binary") {
+		is_converted = ParticleIO::convertTextToBinary(file_path, converted_path);
+	}
+	else {
+		is_converted = ParticleIO::compressFrames(file_path, converted_path, sph_manager.getFrameTolerance());
+	}
+
+	// console feedback
+	if (is_converted) {
+		std::cout << "Frames converted." << std::endl;
+	}
+	else {
+		std::cout << "Conversion failed." << std::endl;
+	}
+}
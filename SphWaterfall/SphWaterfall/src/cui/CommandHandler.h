@@ -1,6 +1,9 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <deque>
+#include <chrono>
 
 #include "mpi.h"
 
@@ -11,6 +14,8 @@
 #include "../geometry/TerrainParser.h"
 #include "../visualization/VisualizationManager.h"
 #include "../data/ParticleIO.h"
+#include "../data/AsyncFrameWriter.h"
+#include "../data/CheckpointReader.h"
 
 class CommandHandler {
 	public:
@@ -44,4 +49,9 @@ class CommandHandler {
 		void render(Terrain, Terrain, int, Vector3, unsigned int, unsigned int);
 		void addSource(std::string);
 		void addSink(std::string);
+		void setOption(std::string);
+		void setOutput(CUICommand&);
+		std::string getFrameFileName();
+		void convertFrames(std::string, std::string);
+		void restart(std::string);
 };
@@ -0,0 +1,107 @@
+#include "AsyncFrameWriter.h"
+
+AsyncFrameWriter::AsyncFrameWriter(string fileName, ParticleStreamWriter::Format format, double tolerance, bool with_ids, bool is_vtu, const OutputScheduler& output_scheduler,
+	int first_timestep, int last_timestep, int queue_length) :
+	output_scheduler(output_scheduler),
+	particle_writer(fileName, output_scheduler.countDue(OutputScheduler::FRAME_STREAM, first_timestep, last_timestep), format, tolerance, with_ids),
+	queue_length(queue_length),
+	is_vtu(is_vtu),
+	is_finished(false),
+	written_frames(0),
+	written_particles(0),
+	write_seconds(0.0)
+{
+	writer_thread = thread(&AsyncFrameWriter::run, this);
+}
+
+AsyncFrameWriter::~AsyncFrameWriter() {
+	finish();
+}
+
+void AsyncFrameWriter::push(vector<SphParticle>& particles, vector<long long>& proc_boundaries, int timestep) {
+	unique_lock<mutex> lock(queue_mutex);
+	queue_changed.wait(lock, [this] { return queue.size() < queue_length; });
+
+	queue.emplace_back();
+	queue.back().timestep = timestep;
+	queue.back().particles.swap(particles);
+	queue.back().proc_boundaries.swap(proc_boundaries);
+	queue_changed.notify_all();
+}
+
+void AsyncFrameWriter::finish() {
+	{
+		lock_guard<mutex> lock(queue_mutex);
+		if (is_finished) {
+			return;
+		}
+		is_finished = true;
+	}
+	queue_changed.notify_all();
+	writer_thread.join();
+	chrono::steady_clock::time_point close_start_time = chrono::steady_clock::now();
+	particle_writer.close();
+	if (!vtk_time_series.empty()) {
+		ParticleIO::exportPVD("vtk/particles.pvd", vtk_time_series);
+	}
+	write_seconds += chrono::duration<double>(chrono::steady_clock::now() - close_start_time).count();
+
+	if (written_frames != 0) {
+		double megabytes = written_particles * PARTICLE_RECORD_SIZE * sizeof(double) / 1048576.0;
+		cout << "Wrote " << written_frames << " frames with " << written_particles << " particles in " << write_seconds << " s ("
+			<< megabytes / std::max(write_seconds, 1e-9) << " MiB/s of particle records)." << endl;
+	}
+}
+
+void AsyncFrameWriter::run() {
+	while (true) {
+		QueuedFrame frame;
+		{
+			unique_lock<mutex> lock(queue_mutex);
+			queue_changed.wait(lock, [this] { return !queue.empty() || is_finished; });
+			if (queue.empty()) {
+				return;
+			}
+			frame = move(queue.front());
+			queue.pop_front();
+		}
+		queue_changed.notify_all();
+
+		chrono::steady_clock::time_point write_start_time = chrono::steady_clock::now();
+		vector<SphParticle> particles;
+		vector<long long> proc_boundaries;
+		if (output_scheduler.isDue(OutputScheduler::VTK_STREAM, frame.timestep)) {
+			filterFrame(OutputScheduler::VTK_STREAM, frame, particles, proc_boundaries);
+			int fields = output_scheduler.getFields(OutputScheduler::VTK_STREAM);
+			if (is_vtu) {
+				string fileName = ParticleIO::exportParticlesToVTU(particles, "vtk/particles", frame.timestep, proc_boundaries, fields);
+				vtk_time_series.emplace_back(frame.timestep * TIMESTEP_DURATION, fileName);
+			}
+			else {
+				ParticleIO::exportParticlesToVTK(particles, "vtk/particles", frame.timestep, proc_boundaries, fields);
+			}
+		}
+		if (output_scheduler.isDue(OutputScheduler::FRAME_STREAM, frame.timestep)) {
+			filterFrame(OutputScheduler::FRAME_STREAM, frame, particles, proc_boundaries);
+			particle_writer.appendFrame(particles, frame.timestep);
+		}
+		written_frames++;
+		written_particles += static_cast<long long>(frame.particles.size());
+		write_seconds += chrono::duration<double>(chrono::steady_clock::now() - write_start_time).count();
+	}
+}
+
+void AsyncFrameWriter::filterFrame(OutputScheduler::Stream stream, QueuedFrame& frame, vector<SphParticle>& particles, vector<long long>& proc_boundaries) {
+	particles.clear();
+	proc_boundaries.assign(frame.proc_boundaries.size(), 0);
+	long long index = 0;
+	for (size_t p = 0; p < frame.proc_boundaries.size(); p++) {
+		for (long long i = 0; i < frame.proc_boundaries[p]; i++, index++) {
+			const SphParticle& particle = frame.particles[index];
+			if (output_scheduler.isInRegion(stream, particle.position) && output_scheduler.isInContent(stream, particle.isSurface(), particle.isInteriorCell())) {
+				particles.push_back(particle);
+				proc_boundaries[p]++;
+			}
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "SphParticle.h"
+#include "ParticleIO.h"
+#include "ParticleStreamWriter.h"
+#include "../simulation/OutputScheduler.h"
+
+using namespace std;
+// Writes the vtk files and sph.ptcl frames that are due on a background thread, so the master can receive
+// the next frame meanwhile. push only blocks while queue_length frames are waiting to be written
+class AsyncFrameWriter {
+public:
+	AsyncFrameWriter(string fileName, ParticleStreamWriter::Format format, double tolerance, bool with_ids, bool is_vtu, const OutputScheduler& output_scheduler,
+		int first_timestep, int last_timestep, int queue_length);
+	~AsyncFrameWriter();
+
+	// takes over the contents of both vectors
+	void push(vector<SphParticle>& particles, vector<long long>& proc_boundaries, int timestep);
+	// writes the remaining frames, stops the thread and writes the pvd time series of the vtu files.
+	// Reports how fast the frames were written
+	void finish();
+
+private:
+	struct QueuedFrame {
+		int timestep;
+		vector<SphParticle> particles;
+		vector<long long> proc_boundaries;
+	};
+
+	// a copy, the settings may change while frames are still written
+	OutputScheduler output_scheduler;
+	ParticleStreamWriter particle_writer;
+	int queue_length;
+	// vtu pieces per process with a pvtu file and a pvd time series instead of legacy vtk files
+	bool is_vtu;
+	vector<pair<double, string>> vtk_time_series;
+	bool is_finished;
+	// of the writer thread, only read after it stopped
+	long long written_frames;
+	long long written_particles;
+	double write_seconds;
+	deque<QueuedFrame> queue;
+	mutex queue_mutex;
+	condition_variable queue_changed;
+	thread writer_thread;
+
+	void run();
+	// particles of the frame inside the region of the stream, with the number of particles per process
+	void filterFrame(OutputScheduler::Stream stream, QueuedFrame& frame, vector<SphParticle>& particles, vector<long long>& proc_boundaries);
+};
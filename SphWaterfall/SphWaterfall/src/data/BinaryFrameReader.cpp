@@ -0,0 +1,164 @@
+#include "BinaryFrameReader.h"
+
+#include <cstring>
+#include <fstream>
+
+BinaryFrameReader::BinaryFrameReader() :
+	data(nullptr),
+	size(0),
+	record_size(PARTICLE_RECORD_SIZE)
+{
+}
+
+BinaryFrameReader::~BinaryFrameReader() {
+	close();
+}
+
+bool BinaryFrameReader::open(string fileName) {
+	close();
+	if (!file.open(fileName)) {
+		cout << "Unable to open file " << fileName << "\n";
+		return false;
+	}
+	data = file.getData();
+	size = file.getSize();
+
+	if (size < BINARY_FRAME_HEADER_SIZE || memcmp(data, BINARY_FRAME_MAGIC, 8) != 0) {
+		cout << fileName << " is not a binary frame file.\n";
+		close();
+		return false;
+	}
+	record_size = static_cast<int>(getUInt32(data + 12));
+	if (getUInt32(data + 8) != BINARY_FRAME_VERSION || (record_size != PARTICLE_RECORD_SIZE && record_size != PARTICLE_RECORD_SIZE_WITH_ID)) {
+		cout << fileName << " has an unsupported version.\n";
+		close();
+		return false;
+	}
+
+	unsigned long long frame_count = getUInt64(data + 16);
+	unsigned long long table_offset = getUInt64(data + 24);
+	if (table_offset < BINARY_FRAME_HEADER_SIZE || table_offset > size
+		|| frame_count > (size - table_offset) / BINARY_FRAME_TABLE_ENTRY_SIZE) {
+		// the writer didn't get to close, the index next to the file has the frames written up to then
+		if (!loadIndex(fileName + ".idx")) {
+			cout << fileName << " is incomplete, the frame table is missing.\n";
+			close();
+			return false;
+		}
+		cout << fileName << " is incomplete, " << frames.size() << " frames were recovered from " << fileName << ".idx.\n";
+		return true;
+	}
+
+	frames.resize(frame_count);
+	for (unsigned long long i = 0; i < frame_count; i++) {
+		frames[i] = getFrameEntry(data + table_offset + i * BINARY_FRAME_TABLE_ENTRY_SIZE);
+		if (!isInRecords(frames[i], table_offset)) {
+			cout << fileName << " has a frame outside of the records.\n";
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void BinaryFrameReader::close() {
+	frames.clear();
+	file.close();
+	data = nullptr;
+	size = 0;
+}
+
+bool BinaryFrameReader::isOpen() const {
+	return data != nullptr;
+}
+
+size_t BinaryFrameReader::getFrameCount() const {
+	return frames.size();
+}
+
+long long BinaryFrameReader::getFrameNumber(size_t frame) const {
+	return frames.at(frame).frame_number;
+}
+
+long long BinaryFrameReader::getParticleCount(size_t frame) const {
+	return static_cast<long long>(frames.at(frame).particle_count);
+}
+
+bool BinaryFrameReader::hasIds() const {
+	return record_size == PARTICLE_RECORD_SIZE_WITH_ID;
+}
+
+void BinaryFrameReader::readFrame(size_t frame, vector<SphParticle>& particles) const {
+	const FrameEntry& entry = frames.at(frame);
+	particles.clear();
+	particles.reserve(entry.particle_count);
+
+	const char* record = data + entry.offset;
+	for (unsigned long long i = 0; i < entry.particle_count; i++) {
+		particles.emplace_back(SphParticle(
+			Vector3(getDouble(record), getDouble(record + 8), getDouble(record + 16)),
+			Vector3(getDouble(record + 24), getDouble(record + 32), getDouble(record + 40)),
+			getDouble(record + 48)
+		));
+		if (record_size == PARTICLE_RECORD_SIZE_WITH_ID) {
+			particles.back().id = getUInt64(record + 56);
+		}
+		record += record_size * sizeof(double);
+	}
+}
+
+BinaryFrameReader::FrameEntry BinaryFrameReader::getFrameEntry(const char* source) {
+	return { static_cast<long long>(getUInt64(source)), getUInt64(source + 8), getUInt64(source + 16) };
+}
+
+bool BinaryFrameReader::isInRecords(const FrameEntry& entry, unsigned long long records_end) const {
+	const unsigned long long record_bytes = record_size * sizeof(double);
+	return entry.offset >= BINARY_FRAME_HEADER_SIZE && entry.offset <= records_end && entry.particle_count <= (records_end - entry.offset) / record_bytes;
+}
+
+bool BinaryFrameReader::loadIndex(string indexFileName) {
+	ifstream index_file(indexFileName, ios::binary);
+	if (!index_file.is_open()) {
+		return false;
+	}
+
+	// a frame whose records weren't written completely ends the recovered frames
+	char entry[BINARY_FRAME_TABLE_ENTRY_SIZE];
+	while (index_file.read(entry, BINARY_FRAME_TABLE_ENTRY_SIZE)) {
+		FrameEntry frame = getFrameEntry(entry);
+		if (!isInRecords(frame, size)) {
+			break;
+		}
+		frames.push_back(frame);
+	}
+	return true;
+}
+
+bool BinaryFrameReader::isBinaryFrameFile(string fileName) {
+	ifstream file(fileName, ios::binary);
+	char magic[8];
+	return file.read(magic, 8) && memcmp(magic, BINARY_FRAME_MAGIC, 8) == 0;
+}
+
+unsigned int BinaryFrameReader::getUInt32(const char* source) {
+	unsigned int value = 0;
+	for (int i = 0; i < 4; i++) {
+		value |= static_cast<unsigned int>(static_cast<unsigned char>(source[i])) << (8 * i);
+	}
+	return value;
+}
+
+unsigned long long BinaryFrameReader::getUInt64(const char* source) {
+	unsigned long long value = 0;
+	for (int i = 0; i < 8; i++) {
+		value |= static_cast<unsigned long long>(static_cast<unsigned char>(source[i])) << (8 * i);
+	}
+	return value;
+}
+
+double BinaryFrameReader::getDouble(const char* source) {
+	unsigned long long bits = getUInt64(source);
+	double value;
+	memcpy(&value, &bits, sizeof(double));
+	return value;
+}
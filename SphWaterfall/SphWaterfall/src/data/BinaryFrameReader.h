@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "SphParticle.h"
+#include "BinaryFrameWriter.h"
+#include "MappedFile.h"
+
+using namespace std;
+// Maps a file of the binary frame format into memory. Only the header and the frame table are read on open,
+// every frame can then be read on its own without touching the others. A file without frame table is read
+// through the index the writer keeps next to it
+class BinaryFrameReader {
+public:
+	BinaryFrameReader();
+	~BinaryFrameReader();
+	BinaryFrameReader(const BinaryFrameReader&) = delete;
+	BinaryFrameReader& operator=(const BinaryFrameReader&) = delete;
+
+	bool open(string fileName);
+	void close();
+	bool isOpen() const;
+
+	size_t getFrameCount() const;
+	long long getFrameNumber(size_t frame) const;
+	long long getParticleCount(size_t frame) const;
+	// the records carry particle ids
+	bool hasIds() const;
+	// replaces the contents of particles with the frame at position frame of the table
+	void readFrame(size_t frame, vector<SphParticle>& particles) const;
+
+	// checks the magic at the start of the file
+	static bool isBinaryFrameFile(string fileName);
+
+	static unsigned int getUInt32(const char* source);
+	static unsigned long long getUInt64(const char* source);
+	static double getDouble(const char* source);
+
+private:
+	struct FrameEntry {
+		long long frame_number;
+		unsigned long long offset;
+		unsigned long long particle_count;
+	};
+
+	MappedFile file;
+	const char* data;
+	size_t size;
+	int record_size;
+	vector<FrameEntry> frames;
+
+	static FrameEntry getFrameEntry(const char* source);
+	// the records of the frame lie between the header and records_end
+	bool isInRecords(const FrameEntry& entry, unsigned long long records_end) const;
+	bool loadIndex(string indexFileName);
+};
@@ -0,0 +1,129 @@
+#include "BinaryFrameWriter.h"
+
+#include <cstdio>
+#include <cstring>
+
+BinaryFrameWriter::BinaryFrameWriter() :
+	file_size(0),
+	record_size(PARTICLE_RECORD_SIZE)
+{
+}
+
+BinaryFrameWriter::~BinaryFrameWriter() {
+	close();
+}
+
+bool BinaryFrameWriter::open(string fileName, bool with_ids) {
+	close();
+	file.open(fileName, ios::binary | ios::trunc);
+	index_file_name = fileName + ".idx";
+	index_file.open(index_file_name, ios::binary | ios::trunc);
+	if (!file.is_open() || !index_file.is_open()) {
+		cout << "Unable to open file";
+		file.close();
+		index_file.close();
+		return false;
+	}
+	frames.clear();
+	record_size = with_ids ? PARTICLE_RECORD_SIZE_WITH_ID : PARTICLE_RECORD_SIZE;
+
+	// completed by close, a file without frame table is recognised as unfinished
+	char header[BINARY_FRAME_HEADER_SIZE] = {};
+	memcpy(header, BINARY_FRAME_MAGIC, 8);
+	putUInt32(header + 8, BINARY_FRAME_VERSION);
+	putUInt32(header + 12, record_size);
+	file.write(header, BINARY_FRAME_HEADER_SIZE);
+	file_size = BINARY_FRAME_HEADER_SIZE;
+	file.flush();
+	return true;
+}
+
+void BinaryFrameWriter::appendFrame(const vector<SphParticle>& particles, long long frame_number) {
+	if (!file.is_open()) {
+		return;
+	}
+	frames.push_back({ frame_number, file_size, particles.size() });
+
+	buffer.resize(particles.size() * record_size * sizeof(double));
+	char* record = buffer.data();
+	for (const SphParticle& each_particle : particles) {
+		putRecord(record, each_particle, record_size);
+		record += record_size * sizeof(double);
+	}
+	file.write(buffer.data(), buffer.size());
+	file_size += buffer.size();
+	// the records first, so the index never points past the end of the file
+	file.flush();
+
+	char entry[BINARY_FRAME_TABLE_ENTRY_SIZE];
+	putFrameEntry(entry, frame_number, frames.back().offset, frames.back().particle_count);
+	index_file.write(entry, BINARY_FRAME_TABLE_ENTRY_SIZE);
+	index_file.flush();
+}
+
+void BinaryFrameWriter::close() {
+	if (!file.is_open()) {
+		return;
+	}
+	unsigned long long table_offset = file_size;
+	buffer.resize(frames.size() * BINARY_FRAME_TABLE_ENTRY_SIZE);
+	char* entry = buffer.data();
+	for (FrameEntry& each_frame : frames) {
+		putFrameEntry(entry, each_frame.frame_number, each_frame.offset, each_frame.particle_count);
+		entry += BINARY_FRAME_TABLE_ENTRY_SIZE;
+	}
+	file.write(buffer.data(), buffer.size());
+
+	char counts[16];
+	putUInt64(counts, frames.size());
+	putUInt64(counts + 8, table_offset);
+	file.seekp(16);
+	file.write(counts, 16);
+	file.close();
+	buffer = vector<char>();
+
+	// the table replaces the index
+	index_file.close();
+	remove(index_file_name.c_str());
+}
+
+bool BinaryFrameWriter::isOpen() const {
+	return file.is_open();
+}
+
+void BinaryFrameWriter::putUInt32(char* destination, unsigned int value) {
+	for (int i = 0; i < 4; i++) {
+		destination[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+	}
+}
+
+void BinaryFrameWriter::putUInt64(char* destination, unsigned long long value) {
+	for (int i = 0; i < 8; i++) {
+		destination[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+	}
+}
+
+void BinaryFrameWriter::putDouble(char* destination, double value) {
+	unsigned long long bits;
+	memcpy(&bits, &value, sizeof(double));
+	putUInt64(destination, bits);
+}
+
+void BinaryFrameWriter::putFrameEntry(char* destination, long long frame_number, unsigned long long offset, unsigned long long particle_count) {
+	putUInt64(destination, static_cast<unsigned long long>(frame_number));
+	putUInt64(destination + 8, offset);
+	putUInt64(destination + 16, particle_count);
+}
+
+void BinaryFrameWriter::putRecord(char* destination, const SphParticle& particle, int record_size) {
+	putDouble(destination, particle.position.x);
+	putDouble(destination + 8, particle.position.y);
+	putDouble(destination + 16, particle.position.z);
+	putDouble(destination + 24, particle.velocity.x);
+	putDouble(destination + 32, particle.velocity.y);
+	putDouble(destination + 40, particle.velocity.z);
+	putDouble(destination + 48, particle.mass);
+	if (record_size == PARTICLE_RECORD_SIZE_WITH_ID) {
+		putUInt64(destination + 56, particle.id);
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include "SphParticle.h"
+#include "../simulation/SimulationUtilities.h"
+
+// binary frame format, every number little endian
+#define BINARY_FRAME_MAGIC "SPHFRAME"
+#define BINARY_FRAME_VERSION 1
+// magic, version, doubles per particle, frame count, offset of the frame table
+#define BINARY_FRAME_HEADER_SIZE 32
+// frame number, byte offset of the first record, particle count
+#define BINARY_FRAME_TABLE_ENTRY_SIZE 24
+
+using namespace std;
+// Writes frames in the binary frame format:
+// header:  "SPHFRAME", uint32 version, uint32 doubles per particle, uint64 frame count, uint64 offset of the frame table
+// records: x, y, z, vx, vy, vz, mass as doubles per particle, followed by the id as uint64 if the file has ids,
+//          one frame after another
+// table:   int64 frame number, uint64 byte offset of the first record, uint64 particle count per frame
+// The table and the header are completed by close, so frames can be appended without knowing their number in advance.
+// Until then the table entries are appended to <fileName>.idx after every frame, so the frames of a crashed run can still be read
+class BinaryFrameWriter {
+public:
+	BinaryFrameWriter();
+	~BinaryFrameWriter();
+
+	// with_ids writes records of PARTICLE_RECORD_SIZE_WITH_ID
+	bool open(string fileName, bool with_ids = false);
+	void appendFrame(const vector<SphParticle>& particles, long long frame_number);
+	void close();
+	bool isOpen() const;
+
+	static void putUInt32(char* destination, unsigned int value);
+	static void putUInt64(char* destination, unsigned long long value);
+	static void putDouble(char* destination, double value);
+	static void putFrameEntry(char* destination, long long frame_number, unsigned long long offset, unsigned long long particle_count);
+	// record_size doubles, the id in the eighth place
+	static void putRecord(char* destination, const SphParticle& particle, int record_size);
+
+private:
+	struct FrameEntry {
+		long long frame_number;
+		unsigned long long offset;
+		unsigned long long particle_count;
+	};
+
+	ofstream file;
+	ofstream index_file;
+	string index_file_name;
+	unsigned long long file_size;
+	int record_size;
+	vector<FrameEntry> frames;
+	vector<char> buffer;
+};
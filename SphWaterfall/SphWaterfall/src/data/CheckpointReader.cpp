@@ -0,0 +1,95 @@
+#include "CheckpointReader.h"
+#include "BinaryFrameReader.h"
+
+#include <cstring>
+#include <fstream>
+
+bool CheckpointReader::readState(string fileName, CheckpointState& state, unsigned long long& particle_count) {
+	ifstream file(fileName, ios::binary);
+	char header[CHECKPOINT_HEADER_SIZE];
+	if (!file.read(header, CHECKPOINT_HEADER_SIZE) || memcmp(header, CHECKPOINT_MAGIC, 8) != 0) {
+		cout << fileName << " is not a checkpoint.\n";
+		return false;
+	}
+	if (BinaryFrameReader::getUInt32(header + 8) != CHECKPOINT_VERSION || BinaryFrameReader::getUInt32(header + 12) != CHECKPOINT_RECORD_SIZE) {
+		cout << fileName << " has an unsupported version.\n";
+		return false;
+	}
+
+	state.timestep = static_cast<long long>(BinaryFrameReader::getUInt64(header + 16));
+	particle_count = BinaryFrameReader::getUInt64(header + 24);
+	state.sink_height = BinaryFrameReader::getDouble(header + 32);
+	state.shutter_timestep = static_cast<long long>(BinaryFrameReader::getUInt64(header + 40));
+	state.particle_id_count = BinaryFrameReader::getUInt64(header + 48);
+
+	unsigned long long source_count = BinaryFrameReader::getUInt64(header + 56);
+	vector<char> sources(24 * source_count);
+	if (source_count > 1048576 || !file.read(sources.data(), sources.size())) {
+		cout << fileName << " is incomplete.\n";
+		return false;
+	}
+	state.sources.clear();
+	for (unsigned long long i = 0; i < source_count; i++) {
+		const char* source = sources.data() + 24 * i;
+		state.sources.push_back(Vector3(BinaryFrameReader::getDouble(source), BinaryFrameReader::getDouble(source + 8), BinaryFrameReader::getDouble(source + 16)));
+	}
+
+	// the records have to be complete
+	file.seekg(0, ios::end);
+	unsigned long long file_size = static_cast<unsigned long long>(file.tellg());
+	unsigned long long records_offset = CHECKPOINT_HEADER_SIZE + 24 * source_count;
+	if (file_size < records_offset || particle_count > (file_size - records_offset) / CHECKPOINT_RECORD_SIZE) {
+		cout << fileName << " is incomplete.\n";
+		return false;
+	}
+	return true;
+}
+
+bool CheckpointReader::read(MPI_Comm comm, string fileName, CheckpointState& state, vector<SphParticle>& particles) {
+	particles.clear();
+	unsigned long long particle_count;
+	if (!readState(fileName, state, particle_count)) {
+		return false;
+	}
+
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+	long long first = static_cast<long long>(particle_count * rank / size);
+	long long count = static_cast<long long>(particle_count * (rank + 1) / size) - first;
+	long long max_count = static_cast<long long>((particle_count + size - 1) / size);
+
+	MPI_File file;
+	MPI_Datatype record_datatype;
+	MPI_File_open(comm, fileName.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file);
+	MPI_Type_contiguous(CHECKPOINT_RECORD_SIZE, MPI_BYTE, &record_datatype);
+	MPI_Type_commit(&record_datatype);
+
+	// collective calls must match, so every process reads as many chunks as the largest share needs
+	MPI_Offset records_offset = CHECKPOINT_HEADER_SIZE + 24 * static_cast<MPI_Offset>(state.sources.size());
+	vector<char> records(count * CHECKPOINT_RECORD_SIZE);
+	long long read = 0;
+	do {
+		int chunk = static_cast<int>(std::min<long long>(count - read, MAX_PARTICLES_PER_MESSAGE));
+		MPI_File_read_at_all(file, records_offset + (first + read) * CHECKPOINT_RECORD_SIZE, records.data() + read * CHECKPOINT_RECORD_SIZE,
+			chunk, record_datatype, MPI_STATUS_IGNORE);
+		read += chunk;
+		max_count -= MAX_PARTICLES_PER_MESSAGE;
+	} while (max_count > 0);
+	MPI_File_close(&file);
+	MPI_Type_free(&record_datatype);
+
+	particles.reserve(count);
+	const char* record = records.data();
+	for (long long i = 0; i < count; i++) {
+		SphParticle particle(Vector3(BinaryFrameReader::getDouble(record), BinaryFrameReader::getDouble(record + 8), BinaryFrameReader::getDouble(record + 16)),
+			static_cast<SphParticle::ParticleType>(BinaryFrameReader::getUInt64(record + 72)));
+		particle.velocity = Vector3(BinaryFrameReader::getDouble(record + 24), BinaryFrameReader::getDouble(record + 32), BinaryFrameReader::getDouble(record + 40));
+		particle.mass = BinaryFrameReader::getDouble(record + 48);
+		particle.local_density = BinaryFrameReader::getDouble(record + 56);
+		particle.id = BinaryFrameReader::getUInt64(record + 64);
+		particles.push_back(particle);
+		record += CHECKPOINT_RECORD_SIZE;
+	}
+	return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "mpi.h"
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "SphParticle.h"
+#include "CheckpointWriter.h"
+
+using namespace std;
+// Reads checkpoints of CheckpointWriter. The records are split evenly over the reading processes, so a checkpoint
+// can be loaded onto any number of processes. The particles still have to be handed to the process owning their domain
+class CheckpointReader {
+public:
+	// reads the header without MPI, the master takes no part in the simulation but needs the timestep
+	static bool readState(string fileName, CheckpointState& state, unsigned long long& particle_count);
+	// collective on comm, replaces the contents of particles with the share of this process
+	static bool read(MPI_Comm comm, string fileName, CheckpointState& state, vector<SphParticle>& particles);
+};
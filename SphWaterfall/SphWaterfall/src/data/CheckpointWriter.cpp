@@ -0,0 +1,148 @@
+#include "CheckpointWriter.h"
+#include "BinaryFrameWriter.h"
+
+#include <cstdio>
+#include <cstring>
+
+CheckpointWriter::CheckpointWriter() :
+	is_writing(false)
+{
+}
+
+CheckpointWriter::~CheckpointWriter() {
+
+}
+
+void CheckpointWriter::write(MPI_Comm comm, string fileName, const CheckpointState& state, const vector<SphParticle>& particles) {
+	finish();
+	this->comm = comm;
+	this->fileName = fileName;
+	MPI_Comm_rank(comm, &rank);
+
+	// where this process starts inside the records
+	long long count = static_cast<long long>(particles.size());
+	long long count_before = 0;
+	long long total_count;
+	long long max_count;
+	unsigned long long particle_id_count;
+	MPI_Exscan(&count, &count_before, 1, MPI_LONG_LONG, MPI_SUM, comm);
+	if (rank == 0) {
+		count_before = 0;
+	}
+	MPI_Allreduce(&count, &total_count, 1, MPI_LONG_LONG, MPI_SUM, comm);
+	MPI_Allreduce(&count, &max_count, 1, MPI_LONG_LONG, MPI_MAX, comm);
+	MPI_Allreduce(&state.particle_id_count, &particle_id_count, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, comm);
+
+	// every process only holds the sources inside its own domains
+	int size;
+	MPI_Comm_size(comm, &size);
+	int source_values = 3 * static_cast<int>(state.sources.size());
+	vector<double> sources;
+	for (const Vector3& each_source : state.sources) {
+		sources.push_back(each_source.x);
+		sources.push_back(each_source.y);
+		sources.push_back(each_source.z);
+	}
+	vector<int> source_counts(size);
+	vector<int> source_offsets(size, 0);
+	MPI_Gather(&source_values, 1, MPI_INT, source_counts.data(), 1, MPI_INT, 0, comm);
+	for (int i = 1; i < size; i++) {
+		source_offsets[i] = source_offsets[i - 1] + source_counts[i - 1];
+	}
+	vector<double> all_sources(source_offsets[size - 1] + source_counts[size - 1]);
+	MPI_Gatherv(sources.data(), source_values, MPI_DOUBLE, all_sources.data(), source_counts.data(), source_offsets.data(), MPI_DOUBLE, 0, comm);
+	long long source_count = static_cast<long long>(all_sources.size() / 3);
+	MPI_Bcast(&source_count, 1, MPI_LONG_LONG, 0, comm);
+
+	MPI_Offset header_size = CHECKPOINT_HEADER_SIZE + 24 * static_cast<MPI_Offset>(source_count);
+	if (rank == 0) {
+		header.assign(header_size, 0);
+		memcpy(header.data(), CHECKPOINT_MAGIC, 8);
+		BinaryFrameWriter::putUInt32(header.data() + 8, CHECKPOINT_VERSION);
+		BinaryFrameWriter::putUInt32(header.data() + 12, CHECKPOINT_RECORD_SIZE);
+		BinaryFrameWriter::putUInt64(header.data() + 16, static_cast<unsigned long long>(state.timestep));
+		BinaryFrameWriter::putUInt64(header.data() + 24, static_cast<unsigned long long>(total_count));
+		BinaryFrameWriter::putDouble(header.data() + 32, state.sink_height);
+		BinaryFrameWriter::putUInt64(header.data() + 40, static_cast<unsigned long long>(state.shutter_timestep));
+		BinaryFrameWriter::putUInt64(header.data() + 48, particle_id_count);
+		BinaryFrameWriter::putUInt64(header.data() + 56, static_cast<unsigned long long>(source_count));
+		for (size_t i = 0; i < all_sources.size(); i++) {
+			BinaryFrameWriter::putDouble(header.data() + CHECKPOINT_HEADER_SIZE + 8 * i, all_sources[i]);
+		}
+	}
+
+	records.resize(particles.size() * CHECKPOINT_RECORD_SIZE);
+	char* record = records.data();
+	for (const SphParticle& each_particle : particles) {
+		BinaryFrameWriter::putDouble(record, each_particle.position.x);
+		BinaryFrameWriter::putDouble(record + 8, each_particle.position.y);
+		BinaryFrameWriter::putDouble(record + 16, each_particle.position.z);
+		BinaryFrameWriter::putDouble(record + 24, each_particle.velocity.x);
+		BinaryFrameWriter::putDouble(record + 32, each_particle.velocity.y);
+		BinaryFrameWriter::putDouble(record + 40, each_particle.velocity.z);
+		BinaryFrameWriter::putDouble(record + 48, each_particle.mass);
+		BinaryFrameWriter::putDouble(record + 56, each_particle.local_density);
+		BinaryFrameWriter::putUInt64(record + 64, each_particle.id);
+		BinaryFrameWriter::putUInt64(record + 72, static_cast<unsigned long long>(each_particle.getParticleType()));
+		record += CHECKPOINT_RECORD_SIZE;
+	}
+
+	MPI_File_open(comm, (fileName + ".tmp").c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+	MPI_File_set_size(file, 0);
+	MPI_Type_contiguous(CHECKPOINT_RECORD_SIZE, MPI_BYTE, &record_datatype);
+	MPI_Type_commit(&record_datatype);
+
+	if (rank == 0) {
+		requests.emplace_back();
+		MPI_File_iwrite_at(file, 0, header.data(), static_cast<int>(header.size()), MPI_BYTE, &requests.back());
+	}
+	// collective calls must match, so every process writes as many chunks as the largest part needs
+	long long written = 0;
+	do {
+		int chunk = static_cast<int>(std::min<long long>(count - written, MAX_PARTICLES_PER_MESSAGE));
+		requests.emplace_back();
+		MPI_File_iwrite_at_all(file, header_size + (count_before + written) * CHECKPOINT_RECORD_SIZE, records.data() + written * CHECKPOINT_RECORD_SIZE,
+			chunk, record_datatype, &requests.back());
+		written += chunk;
+		max_count -= MAX_PARTICLES_PER_MESSAGE;
+	} while (max_count > 0);
+	is_writing = true;
+}
+
+void CheckpointWriter::progress() {
+	if (!is_writing) {
+		return;
+	}
+	int is_complete;
+	MPI_Testall(static_cast<int>(requests.size()), requests.data(), &is_complete, MPI_STATUSES_IGNORE);
+	// the file is only closed and moved in place once every process is done
+	int is_complete_everywhere;
+	MPI_Allreduce(&is_complete, &is_complete_everywhere, 1, MPI_INT, MPI_MIN, comm);
+	if (is_complete_everywhere) {
+		finish();
+	}
+}
+
+void CheckpointWriter::finish() {
+	if (!is_writing) {
+		return;
+	}
+	MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+	requests.clear();
+	MPI_File_close(&file);
+	MPI_Type_free(&record_datatype);
+
+	// every process has written its records before the file replaces the previous checkpoint
+	MPI_Barrier(comm);
+	if (rank == 0) {
+		std::remove(fileName.c_str());
+		std::rename((fileName + ".tmp").c_str(), fileName.c_str());
+	}
+	header = vector<char>();
+	records = vector<char>();
+	is_writing = false;
+}
+
+bool CheckpointWriter::isWriting() const {
+	return is_writing;
+}
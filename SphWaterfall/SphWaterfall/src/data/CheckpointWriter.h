@@ -0,0 +1,58 @@
+#pragma once
+#include "mpi.h"
+#include <vector>
+#include <string>
+
+#include "SphParticle.h"
+
+// checkpoint format, every number little endian
+#define CHECKPOINT_MAGIC "SPHCHKPT"
+#define CHECKPOINT_VERSION 1
+// magic, version, record size, timestep, particle count, sink height, shutter timestep, id counter, source count
+#define CHECKPOINT_HEADER_SIZE 64
+// position, velocity, mass and density as doubles, id and particle type as 64 bit integers
+#define CHECKPOINT_RECORD_SIZE 80
+
+using namespace std;
+// everything besides the particles the simulation needs to continue from a checkpoint
+struct CheckpointState {
+	// last simulated timestep
+	long long timestep;
+	double sink_height;
+	long long shutter_timestep;
+	// most ids given out by one process, every process continues after it on restart
+	unsigned long long particle_id_count;
+	vector<Vector3> sources;
+};
+
+// Writes checkpoints with nonblocking collective MPI-IO. write copies the particles and returns while the file is
+// still being written, so the simulation continues meanwhile. The checkpoint goes to fileName.tmp and only replaces
+// fileName once it is complete, a crash while writing keeps the previous checkpoint.
+// header:  "SPHCHKPT", uint32 version, uint32 record size, int64 timestep, uint64 particle count, double sink height,
+//          int64 shutter timestep, uint64 id counter, uint64 source count, x, y, z as doubles per source
+// records: x, y, z, vx, vy, vz, mass, density as doubles, uint64 id, uint64 particle type per particle, ordered by rank
+class CheckpointWriter {
+public:
+	CheckpointWriter();
+	~CheckpointWriter();
+
+	// collective on comm, completes the previous checkpoint first. The sources of all processes are written together
+	void write(MPI_Comm comm, string fileName, const CheckpointState& state, const vector<SphParticle>& particles);
+	// collective, lets MPI progress the pending write and finishes it once it is complete
+	void progress();
+	// collective, waits for the pending write and moves the file in place
+	void finish();
+	bool isWriting() const;
+
+private:
+	bool is_writing;
+	MPI_Comm comm;
+	int rank;
+	string fileName;
+	MPI_File file;
+	MPI_Datatype record_datatype;
+	// stay untouched until the write is complete
+	vector<char> header;
+	vector<char> records;
+	vector<MPI_Request> requests;
+};
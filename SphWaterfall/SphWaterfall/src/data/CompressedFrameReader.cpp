@@ -0,0 +1,158 @@
+#include "CompressedFrameReader.h"
+
+#include <cstring>
+#include <fstream>
+
+CompressedFrameReader::CompressedFrameReader() :
+	data(nullptr),
+	size(0),
+	keyframe_interval(1),
+	decoded_frame(-1)
+{
+}
+
+CompressedFrameReader::~CompressedFrameReader() {
+	close();
+}
+
+bool CompressedFrameReader::open(string fileName) {
+	close();
+	if (!file.open(fileName)) {
+		cout << "Unable to open file " << fileName << "\n";
+		return false;
+	}
+	data = file.getData();
+	size = file.getSize();
+
+	if (size < COMPRESSED_FRAME_HEADER_SIZE || memcmp(data, COMPRESSED_FRAME_MAGIC, 8) != 0) {
+		cout << fileName << " is not a compressed frame file.\n";
+		close();
+		return false;
+	}
+	keyframe_interval = BinaryFrameReader::getUInt32(data + 12);
+	if (BinaryFrameReader::getUInt32(data + 8) != COMPRESSED_FRAME_VERSION || keyframe_interval == 0) {
+		cout << fileName << " has an unsupported version.\n";
+		close();
+		return false;
+	}
+	codec = FrameCodec(BinaryFrameReader::getDouble(data + 16));
+
+	unsigned long long frame_count = BinaryFrameReader::getUInt64(data + 24);
+	unsigned long long table_offset = BinaryFrameReader::getUInt64(data + 32);
+	if (table_offset < COMPRESSED_FRAME_HEADER_SIZE || table_offset > size
+		|| frame_count > (size - table_offset) / COMPRESSED_FRAME_TABLE_ENTRY_SIZE) {
+		// the writer didn't get to close, the index next to the file has the frames written up to then
+		if (!loadIndex(fileName + ".idx")) {
+			cout << fileName << " is incomplete, the frame table is missing.\n";
+			close();
+			return false;
+		}
+		cout << fileName << " is incomplete, " << frames.size() << " frames were recovered from " << fileName << ".idx.\n";
+		return true;
+	}
+
+	frames.resize(frame_count);
+	for (unsigned long long i = 0; i < frame_count; i++) {
+		frames[i] = getFrameEntry(data + table_offset + i * COMPRESSED_FRAME_TABLE_ENTRY_SIZE);
+		if (!isInFrames(frames[i], table_offset)) {
+			cout << fileName << " has a frame outside of the coded frames.\n";
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void CompressedFrameReader::close() {
+	frames.clear();
+	file.close();
+	data = nullptr;
+	size = 0;
+	codec.reset();
+	decoded_frame = -1;
+}
+
+bool CompressedFrameReader::isOpen() const {
+	return data != nullptr;
+}
+
+size_t CompressedFrameReader::getFrameCount() const {
+	return frames.size();
+}
+
+long long CompressedFrameReader::getFrameNumber(size_t frame) const {
+	return frames.at(frame).frame_number;
+}
+
+CompressedFrameReader::FrameEntry CompressedFrameReader::getFrameEntry(const char* source) {
+	return { static_cast<long long>(BinaryFrameReader::getUInt64(source)), BinaryFrameReader::getUInt64(source + 8),
+		BinaryFrameReader::getUInt64(source + 16), BinaryFrameReader::getUInt64(source + 24) };
+}
+
+bool CompressedFrameReader::isInFrames(const FrameEntry& entry, unsigned long long frames_end) {
+	return entry.offset >= COMPRESSED_FRAME_HEADER_SIZE && entry.offset <= frames_end && entry.size <= frames_end - entry.offset;
+}
+
+bool CompressedFrameReader::loadIndex(string indexFileName) {
+	ifstream index_file(indexFileName, ios::binary);
+	if (!index_file.is_open()) {
+		return false;
+	}
+
+	// a frame that wasn't written completely ends the recovered frames
+	char entry[COMPRESSED_FRAME_TABLE_ENTRY_SIZE];
+	while (index_file.read(entry, COMPRESSED_FRAME_TABLE_ENTRY_SIZE)) {
+		FrameEntry frame = getFrameEntry(entry);
+		if (!isInFrames(frame, size)) {
+			break;
+		}
+		frames.push_back(frame);
+	}
+	return true;
+}
+
+long long CompressedFrameReader::getParticleCount(size_t frame) const {
+	return static_cast<long long>(frames.at(frame).particle_count);
+}
+
+unsigned long long CompressedFrameReader::getCompressedSize() const {
+	unsigned long long compressed_size = 0;
+	for (const FrameEntry& each_frame : frames) {
+		compressed_size += each_frame.size;
+	}
+	return compressed_size;
+}
+
+void CompressedFrameReader::readFrame(size_t frame, vector<SphParticle>& particles) {
+	if (frame >= frames.size()) {
+		particles.clear();
+		return;
+	}
+
+	// continue from the frame decoded last if it lies between the keyframe and this frame
+	size_t next_frame = frame - frame % keyframe_interval;
+	if (decoded_frame >= static_cast<long long>(next_frame) && decoded_frame < static_cast<long long>(frame)) {
+		next_frame = static_cast<size_t>(decoded_frame) + 1;
+	}
+	for (; next_frame <= frame; next_frame++) {
+		const FrameEntry& entry = frames[next_frame];
+		if (!codec.decodeFrame(data + entry.offset, entry.size, particles)) {
+			cout << "Compressed frame " << next_frame << " is damaged. Skipping...\n";
+			particles.clear();
+			codec.reset();
+			decoded_frame = -1;
+			return;
+		}
+		decoded_frame = static_cast<long long>(next_frame);
+	}
+}
+
+const FrameCodec& CompressedFrameReader::getCodec() const {
+	return codec;
+}
+
+bool CompressedFrameReader::isCompressedFrameFile(string fileName) {
+	ifstream file(fileName, ios::binary);
+	char magic[8];
+	return file.read(magic, 8) && memcmp(magic, COMPRESSED_FRAME_MAGIC, 8) == 0;
+}
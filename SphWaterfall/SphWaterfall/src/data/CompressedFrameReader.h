@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "SphParticle.h"
+#include "FrameCodec.h"
+#include "CompressedFrameWriter.h"
+#include "BinaryFrameReader.h"
+#include "MappedFile.h"
+
+using namespace std;
+// Maps a file of the compressed frame format into memory. A frame is decoded from the last keyframe before it,
+// reading the frames in order decodes every frame once. Like a binary frame file, a file without frame table is read through its index
+class CompressedFrameReader {
+public:
+	CompressedFrameReader();
+	~CompressedFrameReader();
+	CompressedFrameReader(const CompressedFrameReader&) = delete;
+	CompressedFrameReader& operator=(const CompressedFrameReader&) = delete;
+
+	bool open(string fileName);
+	void close();
+	bool isOpen() const;
+
+	size_t getFrameCount() const;
+	long long getFrameNumber(size_t frame) const;
+	long long getParticleCount(size_t frame) const;
+	// bytes of the coded frames in the file
+	unsigned long long getCompressedSize() const;
+	// replaces the contents of particles with the frame at position frame of the table
+	void readFrame(size_t frame, vector<SphParticle>& particles);
+
+	const FrameCodec& getCodec() const;
+
+	// checks the magic at the start of the file
+	static bool isCompressedFrameFile(string fileName);
+
+private:
+	struct FrameEntry {
+		long long frame_number;
+		unsigned long long offset;
+		unsigned long long size;
+		unsigned long long particle_count;
+	};
+
+	MappedFile file;
+	const char* data;
+	size_t size;
+	unsigned int keyframe_interval;
+	vector<FrameEntry> frames;
+	FrameCodec codec;
+	// the codec holds this frame as previous frame, -1 for none
+	long long decoded_frame;
+
+	static FrameEntry getFrameEntry(const char* source);
+	// the coded frame lies between the header and frames_end
+	static bool isInFrames(const FrameEntry& entry, unsigned long long frames_end);
+	bool loadIndex(string indexFileName);
+};
@@ -0,0 +1,105 @@
+#include "CompressedFrameWriter.h"
+
+#include <cstdio>
+#include <cstring>
+
+CompressedFrameWriter::CompressedFrameWriter() :
+	keyframe_interval(FRAME_CODEC_KEYFRAME_INTERVAL),
+	file_size(0)
+{
+}
+
+CompressedFrameWriter::~CompressedFrameWriter() {
+	close();
+}
+
+bool CompressedFrameWriter::open(string fileName, double tolerance, int keyframe_interval) {
+	close();
+	file.open(fileName, ios::binary | ios::trunc);
+	index_file_name = fileName + ".idx";
+	index_file.open(index_file_name, ios::binary | ios::trunc);
+	if (!file.is_open() || !index_file.is_open()) {
+		cout << "Unable to open file";
+		file.close();
+		index_file.close();
+		return false;
+	}
+	frames.clear();
+	codec = FrameCodec(tolerance);
+	this->keyframe_interval = (keyframe_interval > 0) ? keyframe_interval : 1;
+
+	char header[COMPRESSED_FRAME_HEADER_SIZE] = {};
+	memcpy(header, COMPRESSED_FRAME_MAGIC, 8);
+	BinaryFrameWriter::putUInt32(header + 8, COMPRESSED_FRAME_VERSION);
+	BinaryFrameWriter::putUInt32(header + 12, static_cast<unsigned int>(this->keyframe_interval));
+	BinaryFrameWriter::putDouble(header + 16, tolerance);
+	file.write(header, COMPRESSED_FRAME_HEADER_SIZE);
+	file_size = COMPRESSED_FRAME_HEADER_SIZE;
+	file.flush();
+	return true;
+}
+
+void CompressedFrameWriter::appendFrame(const vector<SphParticle>& particles, long long frame_number) {
+	if (!file.is_open()) {
+		return;
+	}
+	buffer.clear();
+	codec.encodeFrame(particles, frames.size() % keyframe_interval == 0, buffer);
+	frames.push_back({ frame_number, file_size, buffer.size(), particles.size() });
+
+	file.write(buffer.data(), buffer.size());
+	file_size += buffer.size();
+	// the coded frame first, so the index never points past the end of the file
+	file.flush();
+
+	char entry[COMPRESSED_FRAME_TABLE_ENTRY_SIZE];
+	putFrameEntry(entry, frames.back());
+	index_file.write(entry, COMPRESSED_FRAME_TABLE_ENTRY_SIZE);
+	index_file.flush();
+}
+
+void CompressedFrameWriter::close() {
+	if (!file.is_open()) {
+		return;
+	}
+	unsigned long long table_offset = file_size;
+	buffer.resize(frames.size() * COMPRESSED_FRAME_TABLE_ENTRY_SIZE);
+	char* entry = buffer.data();
+	for (FrameEntry& each_frame : frames) {
+		putFrameEntry(entry, each_frame);
+		entry += COMPRESSED_FRAME_TABLE_ENTRY_SIZE;
+	}
+	file.write(buffer.data(), buffer.size());
+
+	char counts[16];
+	BinaryFrameWriter::putUInt64(counts, frames.size());
+	BinaryFrameWriter::putUInt64(counts + 8, table_offset);
+	file.seekp(24);
+	file.write(counts, 16);
+	file.close();
+	buffer = vector<char>();
+
+	// the table replaces the index
+	index_file.close();
+	remove(index_file_name.c_str());
+
+	if (codec.getEncodedBytes() != 0) {
+		cout << "Compressed " << frames.size() << " frames " << static_cast<double>(codec.getRawBytes()) / codec.getEncodedBytes()
+			<< " : 1 at " << codec.getRawBytes() / 1048576.0 / codec.getEncodeSeconds() << " MiB/s.\n";
+	}
+}
+
+bool CompressedFrameWriter::isOpen() const {
+	return file.is_open();
+}
+
+const FrameCodec& CompressedFrameWriter::getCodec() const {
+	return codec;
+}
+
+void CompressedFrameWriter::putFrameEntry(char* destination, const FrameEntry& frame) {
+	BinaryFrameWriter::putUInt64(destination, static_cast<unsigned long long>(frame.frame_number));
+	BinaryFrameWriter::putUInt64(destination + 8, frame.offset);
+	BinaryFrameWriter::putUInt64(destination + 16, frame.size);
+	BinaryFrameWriter::putUInt64(destination + 24, frame.particle_count);
+}
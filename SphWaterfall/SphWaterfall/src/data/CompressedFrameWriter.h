@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include "SphParticle.h"
+#include "FrameCodec.h"
+#include "BinaryFrameWriter.h"
+
+// compressed frame format, every number little endian
+#define COMPRESSED_FRAME_MAGIC "SPHCFRAM"
+#define COMPRESSED_FRAME_VERSION 1
+// magic, version, keyframe interval, tolerance, frame count, offset of the frame table
+#define COMPRESSED_FRAME_HEADER_SIZE 40
+// frame number, byte offset, byte size and particle count of the coded frame
+#define COMPRESSED_FRAME_TABLE_ENTRY_SIZE 32
+
+using namespace std;
+// Writes frames coded by FrameCodec:
+// header: "SPHCFRAM", uint32 version, uint32 keyframe interval, double tolerance, uint64 frame count, uint64 offset of the frame table
+// frames: the coded frames one after another, every keyframe_interval-th frame is a keyframe starting with the first
+// table:  int64 frame number, uint64 byte offset, uint64 byte size, uint64 particle count per frame
+// Like the binary frame format the table and the header are completed by close, and <fileName>.idx holds the table entries until then
+class CompressedFrameWriter {
+public:
+	CompressedFrameWriter();
+	~CompressedFrameWriter();
+
+	bool open(string fileName, double tolerance = FRAME_CODEC_TOLERANCE, int keyframe_interval = FRAME_CODEC_KEYFRAME_INTERVAL);
+	void appendFrame(const vector<SphParticle>& particles, long long frame_number);
+	// prints the compression ratio and the encode throughput
+	void close();
+	bool isOpen() const;
+
+	const FrameCodec& getCodec() const;
+
+private:
+	struct FrameEntry {
+		long long frame_number;
+		unsigned long long offset;
+		unsigned long long size;
+		unsigned long long particle_count;
+	};
+
+	ofstream file;
+	ofstream index_file;
+	string index_file_name;
+	FrameCodec codec;
+	int keyframe_interval;
+	unsigned long long file_size;
+	vector<FrameEntry> frames;
+	vector<char> buffer;
+
+	static void putFrameEntry(char* destination, const FrameEntry& frame);
+};
@@ -0,0 +1,356 @@
+#include "FrameCodec.h"
+#include "BinaryFrameWriter.h"
+#include "BinaryFrameReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+FrameCodec::FrameCodec(double tolerance) :
+	tolerance(tolerance),
+	raw_bytes(0),
+	encoded_bytes(0),
+	encode_seconds(0.0),
+	decode_seconds(0.0)
+{
+}
+
+FrameCodec::~FrameCodec() {
+
+}
+
+void FrameCodec::encodeFrame(const vector<SphParticle>& particles, bool is_keyframe, vector<char>& buffer) {
+	auto start_time = std::chrono::steady_clock::now();
+	size_t start_size = buffer.size();
+	size_t count = particles.size();
+
+	vector<double> values(count * PARTICLE_RECORD_SIZE);
+	vector<unsigned long long> ids(count);
+	bool has_ids = count != 0;
+	for (size_t i = 0; i < count; i++) {
+		const SphParticle& particle = particles[i];
+		double* record = &values[i * PARTICLE_RECORD_SIZE];
+		record[0] = particle.position.x;
+		record[1] = particle.position.y;
+		record[2] = particle.position.z;
+		record[3] = particle.velocity.x;
+		record[4] = particle.velocity.y;
+		record[5] = particle.velocity.z;
+		record[6] = particle.mass;
+		ids[i] = particle.id;
+		has_ids = has_ids && particle.id != 0;
+	}
+
+	double minimum[PARTICLE_RECORD_SIZE];
+	double step[PARTICLE_RECORD_SIZE];
+	computeSteps(values, count, minimum, step);
+
+	vector<size_t> order(count);
+	std::iota(order.begin(), order.end(), 0);
+	if (has_ids) {
+		std::sort(order.begin(), order.end(), [&ids](size_t a, size_t b) { return ids[a] < ids[b]; });
+		for (size_t k = 1; k < count && has_ids; k++) {
+			has_ids = ids[order[k]] != ids[order[k - 1]];
+		}
+	}
+
+	if (is_keyframe) {
+		reset();
+	}
+	bool is_temporal = has_ids && !previous_ids.empty();
+	if (!is_temporal) {
+		// neighbouring particles get close in the order, so their differences stay small
+		vector<long long> cells(count * 3);
+		long long largest_cell = 0;
+		for (size_t i = 0; i < count * 3; i++) {
+			int channel = static_cast<int>(i % 3);
+			cells[i] = std::llround((values[(i / 3) * PARTICLE_RECORD_SIZE + channel] - minimum[channel]) / step[channel]);
+			largest_cell = std::max(largest_cell, cells[i]);
+		}
+		int shift = 0;
+		while ((largest_cell >> shift) >= (1ll << 21)) {
+			shift++;
+		}
+		vector<pair<unsigned long long, size_t>> codes(count);
+		for (size_t i = 0; i < count; i++) {
+			codes[i] = { mortonCode(cells[3 * i] >> shift, cells[3 * i + 1] >> shift, cells[3 * i + 2] >> shift), i };
+		}
+		std::sort(codes.begin(), codes.end());
+		for (size_t k = 0; k < count; k++) {
+			order[k] = codes[k].second;
+		}
+	}
+
+	// header
+	buffer.resize(start_size + FRAME_CODEC_HEADER_SIZE);
+	char* header = buffer.data() + start_size;
+	header[0] = static_cast<char>((is_keyframe ? FRAME_CODEC_KEYFRAME : 0) | (is_temporal ? FRAME_CODEC_TEMPORAL : 0) | (has_ids ? FRAME_CODEC_HAS_IDS : 0));
+	BinaryFrameWriter::putUInt64(header + 1, count);
+	for (int c = 0; c < PARTICLE_RECORD_SIZE; c++) {
+		BinaryFrameWriter::putDouble(header + 9 + 16 * c, minimum[c]);
+		BinaryFrameWriter::putDouble(header + 17 + 16 * c, step[c]);
+	}
+
+	RangeEncoder encoder(buffer, FRAME_CODEC_CONTEXT_COUNT);
+	vector<unsigned long long> coded_ids(count);
+	vector<double> reconstructed(count * PARTICLE_RECORD_SIZE);
+	unsigned long long last_id = 0;
+	if (is_temporal) {
+		size_t previous = 0;
+		size_t older = 0;
+		double extrapolation[PARTICLE_RECORD_SIZE];
+		const double* last = nullptr;
+		for (size_t k = 0; k < count; k++) {
+			unsigned long long id = ids[order[k]];
+			encoder.encodeValue(PARTICLE_RECORD_SIZE, id - last_id - 1);
+			last_id = id;
+
+			const double* prediction = predict(id, previous, older, extrapolation);
+			if (prediction == nullptr) {
+				prediction = last;
+			}
+			const double* record = &values[order[k] * PARTICLE_RECORD_SIZE];
+			double* result = &reconstructed[k * PARTICLE_RECORD_SIZE];
+			for (int c = 0; c < PARTICLE_RECORD_SIZE; c++) {
+				double base = (prediction != nullptr) ? prediction[c] : minimum[c];
+				long long difference = std::llround((record[c] - base) / step[c]);
+				encoder.encodeValue(c, zigzag(difference));
+				result[c] = base + difference * step[c];
+			}
+			last = result;
+			coded_ids[k] = id;
+		}
+	}
+	else {
+		long long last_cells[PARTICLE_RECORD_SIZE] = {};
+		for (size_t k = 0; k < count; k++) {
+			unsigned long long id = ids[order[k]];
+			if (has_ids) {
+				encoder.encodeValue(PARTICLE_RECORD_SIZE, zigzag(static_cast<long long>(id - last_id)));
+				last_id = id;
+			}
+
+			const double* record = &values[order[k] * PARTICLE_RECORD_SIZE];
+			double* result = &reconstructed[k * PARTICLE_RECORD_SIZE];
+			for (int c = 0; c < PARTICLE_RECORD_SIZE; c++) {
+				long long cell = std::llround((record[c] - minimum[c]) / step[c]);
+				encoder.encodeValue(c, zigzag(cell - last_cells[c]));
+				last_cells[c] = cell;
+				result[c] = minimum[c] + cell * step[c];
+			}
+			coded_ids[k] = id;
+		}
+	}
+	encoder.flush();
+	keepFrame(coded_ids, reconstructed, has_ids);
+
+	raw_bytes += count * PARTICLE_RECORD_SIZE * sizeof(double);
+	encoded_bytes += buffer.size() - start_size;
+	encode_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+bool FrameCodec::decodeFrame(const char* data, size_t size, vector<SphParticle>& particles) {
+	auto start_time = std::chrono::steady_clock::now();
+	particles.clear();
+	if (size < FRAME_CODEC_HEADER_SIZE) {
+		return false;
+	}
+
+	int flags = static_cast<unsigned char>(data[0]);
+	unsigned long long count = BinaryFrameReader::getUInt64(data + 1);
+	double minimum[PARTICLE_RECORD_SIZE];
+	double step[PARTICLE_RECORD_SIZE];
+	for (int c = 0; c < PARTICLE_RECORD_SIZE; c++) {
+		minimum[c] = BinaryFrameReader::getDouble(data + 9 + 16 * c);
+		step[c] = BinaryFrameReader::getDouble(data + 17 + 16 * c);
+	}
+	bool is_temporal = (flags & FRAME_CODEC_TEMPORAL) != 0;
+	bool has_ids = (flags & FRAME_CODEC_HAS_IDS) != 0;
+	if ((flags & FRAME_CODEC_KEYFRAME) != 0) {
+		reset();
+	}
+	// even an unchanged particle takes about a bit, a larger count comes from a damaged header
+	if (count / 64 > size || (is_temporal && (previous_ids.empty() || !has_ids))) {
+		return false;
+	}
+
+	RangeDecoder decoder(data + FRAME_CODEC_HEADER_SIZE, size - FRAME_CODEC_HEADER_SIZE, FRAME_CODEC_CONTEXT_COUNT);
+	vector<unsigned long long> ids(count);
+	vector<double> reconstructed(count * PARTICLE_RECORD_SIZE);
+	unsigned long long last_id = 0;
+	if (is_temporal) {
+		size_t previous = 0;
+		size_t older = 0;
+		double extrapolation[PARTICLE_RECORD_SIZE];
+		const double* last = nullptr;
+		for (size_t k = 0; k < count; k++) {
+			unsigned long long id = last_id + 1 + decoder.decodeValue(PARTICLE_RECORD_SIZE);
+			last_id = id;
+
+			const double* prediction = predict(id, previous, older, extrapolation);
+			if (prediction == nullptr) {
+				prediction = last;
+			}
+			double* result = &reconstructed[k * PARTICLE_RECORD_SIZE];
+			for (int c = 0; c < PARTICLE_RECORD_SIZE; c++) {
+				double base = (prediction != nullptr) ? prediction[c] : minimum[c];
+				result[c] = base + unzigzag(decoder.decodeValue(c)) * step[c];
+			}
+			last = result;
+			ids[k] = id;
+		}
+	}
+	else {
+		long long last_cells[PARTICLE_RECORD_SIZE] = {};
+		for (size_t k = 0; k < count; k++) {
+			if (has_ids) {
+				last_id += static_cast<unsigned long long>(unzigzag(decoder.decodeValue(PARTICLE_RECORD_SIZE)));
+				ids[k] = last_id;
+			}
+
+			double* result = &reconstructed[k * PARTICLE_RECORD_SIZE];
+			for (int c = 0; c < PARTICLE_RECORD_SIZE; c++) {
+				last_cells[c] += unzigzag(decoder.decodeValue(c));
+				result[c] = minimum[c] + last_cells[c] * step[c];
+			}
+		}
+	}
+	if (decoder.isOverrun()) {
+		reset();
+		return false;
+	}
+
+	particles.reserve(count);
+	for (size_t k = 0; k < count; k++) {
+		const double* record = &reconstructed[k * PARTICLE_RECORD_SIZE];
+		particles.emplace_back(SphParticle(Vector3(record[0], record[1], record[2]), Vector3(record[3], record[4], record[5]), record[6]));
+		particles.back().id = ids[k];
+	}
+	keepFrame(ids, reconstructed, has_ids);
+
+	decode_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	return true;
+}
+
+void FrameCodec::reset() {
+	previous_ids.clear();
+	previous_values.clear();
+	older_ids.clear();
+	older_values.clear();
+}
+
+double FrameCodec::getTolerance() const {
+	return tolerance;
+}
+
+unsigned long long FrameCodec::getRawBytes() const {
+	return raw_bytes;
+}
+
+unsigned long long FrameCodec::getEncodedBytes() const {
+	return encoded_bytes;
+}
+
+double FrameCodec::getEncodeSeconds() const {
+	return encode_seconds;
+}
+
+double FrameCodec::getDecodeSeconds() const {
+	return decode_seconds;
+}
+
+void FrameCodec::computeSteps(const vector<double>& values, size_t count, double* minimum, double* step) const {
+	double maximum[PARTICLE_RECORD_SIZE];
+	for (int c = 0; c < PARTICLE_RECORD_SIZE; c++) {
+		minimum[c] = (count != 0) ? values[c] : 0.0;
+		maximum[c] = minimum[c];
+	}
+	for (size_t i = 0; i < count; i++) {
+		for (int c = 0; c < PARTICLE_RECORD_SIZE; c++) {
+			minimum[c] = std::min(minimum[c], values[i * PARTICLE_RECORD_SIZE + c]);
+			maximum[c] = std::max(maximum[c], values[i * PARTICLE_RECORD_SIZE + c]);
+		}
+	}
+
+	// position and velocity share one step over their three axes, the mass has its own
+	const int first_channels[] = { 0, 3, 6, PARTICLE_RECORD_SIZE };
+	for (int group = 0; group < 3; group++) {
+		double extent = 0.0;
+		double magnitude = 0.0;
+		for (int c = first_channels[group]; c < first_channels[group + 1]; c++) {
+			extent = std::max(extent, maximum[c] - minimum[c]);
+			magnitude = std::max(magnitude, std::max(std::fabs(minimum[c]), std::fabs(maximum[c])));
+		}
+		// equal values still need a step, a previous frame may predict others
+		if (extent == 0.0) {
+			extent = std::max(magnitude, 1.0);
+		}
+		for (int c = first_channels[group]; c < first_channels[group + 1]; c++) {
+			step[c] = 2.0 * tolerance * extent;
+		}
+	}
+}
+
+void FrameCodec::keepFrame(vector<unsigned long long>& ids, vector<double>& values, bool has_ids) {
+	if (!has_ids) {
+		reset();
+		return;
+	}
+	older_ids.swap(previous_ids);
+	older_values.swap(previous_values);
+	if (std::is_sorted(ids.begin(), ids.end())) {
+		previous_ids.swap(ids);
+		previous_values.swap(values);
+		return;
+	}
+
+	vector<size_t> order(ids.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&ids](size_t a, size_t b) { return ids[a] < ids[b]; });
+	previous_ids.resize(ids.size());
+	previous_values.resize(values.size());
+	for (size_t k = 0; k < order.size(); k++) {
+		previous_ids[k] = ids[order[k]];
+		std::copy(&values[order[k] * PARTICLE_RECORD_SIZE], &values[order[k] * PARTICLE_RECORD_SIZE] + PARTICLE_RECORD_SIZE, &previous_values[k * PARTICLE_RECORD_SIZE]);
+	}
+}
+
+const double* FrameCodec::predict(unsigned long long id, size_t& previous, size_t& older, double* prediction) const {
+	while (previous < previous_ids.size() && previous_ids[previous] < id) {
+		previous++;
+	}
+	while (older < older_ids.size() && older_ids[older] < id) {
+		older++;
+	}
+	if (previous == previous_ids.size() || previous_ids[previous] != id) {
+		return nullptr;
+	}
+	const double* previous_record = &previous_values[previous * PARTICLE_RECORD_SIZE];
+	if (older == older_ids.size() || older_ids[older] != id) {
+		return previous_record;
+	}
+
+	// the particle keeps moving like between the two previous frames
+	const double* older_record = &older_values[older * PARTICLE_RECORD_SIZE];
+	for (int c = 0; c < PARTICLE_RECORD_SIZE; c++) {
+		prediction[c] = 2.0 * previous_record[c] - older_record[c];
+	}
+	return prediction;
+}
+
+unsigned long long FrameCodec::zigzag(long long value) {
+	return (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63);
+}
+
+long long FrameCodec::unzigzag(unsigned long long value) {
+	return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+}
+
+unsigned long long FrameCodec::mortonCode(unsigned long long x, unsigned long long y, unsigned long long z) {
+	unsigned long long code = 0;
+	for (int bit = 0; bit < 21; bit++) {
+		code |= (((x >> bit) & 1) << (3 * bit)) | (((y >> bit) & 1) << (3 * bit + 1)) | (((z >> bit) & 1) << (3 * bit + 2));
+	}
+	return code;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+#include "SphParticle.h"
+#include "RangeCoder.h"
+#include "../simulation/SimulationUtilities.h"
+
+// flags of a coded frame
+#define FRAME_CODEC_KEYFRAME 1
+#define FRAME_CODEC_TEMPORAL 2
+#define FRAME_CODEC_HAS_IDS 4
+// flags, particle count, minimum and step of the 7 channels
+#define FRAME_CODEC_HEADER_SIZE (1 + 8 + PARTICLE_RECORD_SIZE * 16)
+// one range coder context per channel and one for the ids
+#define FRAME_CODEC_CONTEXT_COUNT (PARTICLE_RECORD_SIZE + 1)
+
+using namespace std;
+// Lossy coder of particle frames. Position, velocity and mass are quantised to a step of
+// 2 * tolerance * extent of their bounding box in the frame, so no value is off by more than tolerance * extent.
+// Keyframes and frames without particle ids sort the particles along a Morton curve and code every quantised value as
+// the difference to the previous particle. Other frames sort by id and code the difference to the same particle
+// extrapolated from the two previous frames, or its value in the previous frame, new particles to the particle before them.
+// The differences are range coded.
+// Encoder and decoder both continue from the reconstructed values, so the error doesn't accumulate over frames
+class FrameCodec {
+public:
+	FrameCodec(double tolerance = FRAME_CODEC_TOLERANCE);
+	~FrameCodec();
+
+	// appends the coded frame to buffer
+	void encodeFrame(const vector<SphParticle>& particles, bool is_keyframe, vector<char>& buffer);
+	// replaces the contents of particles, in the order they were coded in. Frames have to be decoded in the order
+	// they were encoded in, starting at a keyframe. Returns false for a damaged frame
+	bool decodeFrame(const char* data, size_t size, vector<SphParticle>& particles);
+	// forgets the previous frame
+	void reset();
+
+	double getTolerance() const;
+	// bytes of the frames as doubles, bytes of the coded frames and seconds spent coding since construction
+	unsigned long long getRawBytes() const;
+	unsigned long long getEncodedBytes() const;
+	double getEncodeSeconds() const;
+	double getDecodeSeconds() const;
+
+private:
+	double tolerance;
+	// reconstructed values of the previous two frames sorted by id, empty if they had no ids
+	vector<unsigned long long> previous_ids;
+	vector<double> previous_values;
+	vector<unsigned long long> older_ids;
+	vector<double> older_values;
+
+	unsigned long long raw_bytes;
+	unsigned long long encoded_bytes;
+	double encode_seconds;
+	double decode_seconds;
+
+	void computeSteps(const vector<double>& values, size_t count, double* minimum, double* step) const;
+	void keepFrame(vector<unsigned long long>& ids, vector<double>& values, bool has_ids);
+	// the value of the particle with the given id expected in this frame, ids have to be asked for in ascending order
+	const double* predict(unsigned long long id, size_t& previous, size_t& older, double* prediction) const;
+
+	static unsigned long long zigzag(long long value);
+	static long long unzigzag(unsigned long long value);
+	static unsigned long long mortonCode(unsigned long long x, unsigned long long y, unsigned long long z);
+};
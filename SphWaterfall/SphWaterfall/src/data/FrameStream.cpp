@@ -0,0 +1,150 @@
+#include "FrameStream.h"
+
+#include <charconv>
+
+FrameStream::FrameStream() :
+	has_pending_header(false),
+	header_frame_number(0),
+	binary_frame(0),
+	frame_index(-1),
+	frame_number(0),
+	prefetched_frame_number(0),
+	has_prefetched_frame(false)
+{
+}
+
+FrameStream::~FrameStream() {
+	close();
+}
+
+bool FrameStream::open(string fileName) {
+	close();
+	if (BinaryFrameReader::isBinaryFrameFile(fileName)) {
+		if (!binary_reader.open(fileName)) {
+			return false;
+		}
+	}
+	else if (CompressedFrameReader::isCompressedFrameFile(fileName)) {
+		if (!compressed_reader.open(fileName)) {
+			return false;
+		}
+	}
+	else {
+		text_file.open(fileName);
+		if (!text_file.is_open()) {
+			cout << "Unable to open file";
+			return false;
+		}
+	}
+
+	prefetch_thread = thread(&FrameStream::prefetch, this);
+	return true;
+}
+
+void FrameStream::close() {
+	if (prefetch_thread.joinable()) {
+		prefetch_thread.join();
+	}
+	if (text_file.is_open()) {
+		text_file.close();
+	}
+	text_file.clear();
+	binary_reader.close();
+	compressed_reader.close();
+	has_pending_header = false;
+	header_frame_number = 0;
+	binary_frame = 0;
+	frame_index = -1;
+	frame_number = 0;
+	prefetched_frame = vector<SphParticle>();
+	prefetched_frame_number = 0;
+	has_prefetched_frame = false;
+}
+
+bool FrameStream::next(vector<SphParticle>& frame) {
+	if (prefetch_thread.joinable()) {
+		prefetch_thread.join();
+	}
+	if (!has_prefetched_frame) {
+		return false;
+	}
+	frame.swap(prefetched_frame);
+	frame_number = prefetched_frame_number;
+	frame_index++;
+
+	// read the following frame while the caller works on this one
+	prefetch_thread = thread(&FrameStream::prefetch, this);
+	return true;
+}
+
+int FrameStream::getFrameIndex() const {
+	return frame_index;
+}
+
+long long FrameStream::getFrameNumber() const {
+	return frame_number;
+}
+
+void FrameStream::prefetch() {
+	has_prefetched_frame = readFrame(prefetched_frame, prefetched_frame_number);
+}
+
+bool FrameStream::readFrame(vector<SphParticle>& frame, long long& frame_number) {
+	if (binary_reader.isOpen()) {
+		if (binary_frame >= binary_reader.getFrameCount()) {
+			return false;
+		}
+		frame_number = binary_reader.getFrameNumber(binary_frame);
+		binary_reader.readFrame(binary_frame++, frame);
+		return true;
+	}
+	if (compressed_reader.isOpen()) {
+		if (binary_frame >= compressed_reader.getFrameCount()) {
+			return false;
+		}
+		frame_number = compressed_reader.getFrameNumber(binary_frame);
+		compressed_reader.readFrame(binary_frame++, frame);
+		return true;
+	}
+	if (text_file.is_open()) {
+		return readTextFrame(frame, frame_number);
+	}
+	return false;
+}
+
+bool FrameStream::readTextFrame(vector<SphParticle>& frame, long long& frame_number) {
+	frame.clear();
+	string line;
+	if (!has_pending_header) {
+		while (getline(text_file, line) && !startsWith(line, "F")) {
+		}
+		if (!text_file) {
+			return false;
+		}
+		header_frame_number = parseFrameNumber(line);
+	}
+	frame_number = header_frame_number;
+
+	// the particles up to the next frame header or the end of the file
+	while (getline(text_file, line)) {
+		if (startsWith(line, "F")) {
+			has_pending_header = true;
+			header_frame_number = parseFrameNumber(line);
+			return true;
+		}
+		if (!ParticleIO::parseParticle(line, frame)) {
+			cout << "Malformed line found. Skipping...\n";
+		}
+	}
+	has_pending_header = false;
+	return true;
+}
+
+long long FrameStream::parseFrameNumber(const string& header) const {
+	const char* end = header.data() + header.size();
+	long long frame_number;
+	if (header.size() > 2 && header[1] == '#' && std::from_chars(header.data() + 2, end, frame_number).ec == std::errc()) {
+		return frame_number;
+	}
+	return header_frame_number + 1;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <thread>
+
+#include "SphParticle.h"
+#include "ParticleIO.h"
+#include "BinaryFrameReader.h"
+#include "CompressedFrameReader.h"
+
+using namespace std;
+// Yields the frames of a text, binary or compressed frame file one after another. While the caller works on a frame
+// the next one is read on a background thread, so at most two frames are held in memory
+class FrameStream {
+public:
+	FrameStream();
+	~FrameStream();
+	FrameStream(const FrameStream&) = delete;
+	FrameStream& operator=(const FrameStream&) = delete;
+
+	bool open(string fileName);
+	void close();
+
+	// replaces the contents of frame with the next frame, false after the last one
+	bool next(vector<SphParticle>& frame);
+	// position of the frame last returned by next, starting at 0
+	int getFrameIndex() const;
+	// number of the frame last returned by next, the simulation timestep it was written at
+	long long getFrameNumber() const;
+
+private:
+	ifstream text_file;
+	BinaryFrameReader binary_reader;
+	CompressedFrameReader compressed_reader;
+	// a frame header was read whose particles are not returned yet
+	bool has_pending_header;
+	// number from the last frame header read from the text file
+	long long header_frame_number;
+	size_t binary_frame;
+	int frame_index;
+	long long frame_number;
+
+	vector<SphParticle> prefetched_frame;
+	long long prefetched_frame_number;
+	bool has_prefetched_frame;
+	thread prefetch_thread;
+
+	void prefetch();
+	bool readFrame(vector<SphParticle>& frame, long long& frame_number);
+	bool readTextFrame(vector<SphParticle>& frame, long long& frame_number);
+	// number from a "F#frame number#frame count" line, the one after the previous header if it has none
+	long long parseFrameNumber(const string& header) const;
+};
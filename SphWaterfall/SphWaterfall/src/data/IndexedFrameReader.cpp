@@ -0,0 +1,101 @@
+#include "IndexedFrameReader.h"
+
+IndexedFrameReader::IndexedFrameReader() {
+}
+
+IndexedFrameReader::~IndexedFrameReader() {
+	close();
+}
+
+bool IndexedFrameReader::open(string fileName) {
+	close();
+	if (BinaryFrameReader::isBinaryFrameFile(fileName)) {
+		return binary_reader.open(fileName);
+	}
+	if (CompressedFrameReader::isCompressedFrameFile(fileName)) {
+		return compressed_reader.open(fileName);
+	}
+
+	// the parser refuses an index left over from another file
+	vector<long long> frame_offsets;
+	if (loadIndex(fileName + ".idx", frame_offsets) && text_parser.open(fileName, frame_offsets)) {
+		return true;
+	}
+	return text_parser.open(fileName);
+}
+
+bool IndexedFrameReader::open(string fileName, const vector<long long>& frame_offsets) {
+	close();
+	if (BinaryFrameReader::isBinaryFrameFile(fileName)) {
+		return binary_reader.open(fileName);
+	}
+	if (CompressedFrameReader::isCompressedFrameFile(fileName)) {
+		return compressed_reader.open(fileName);
+	}
+	return text_parser.open(fileName, frame_offsets);
+}
+
+void IndexedFrameReader::close() {
+	binary_reader.close();
+	compressed_reader.close();
+	text_parser.close();
+}
+
+bool IndexedFrameReader::hasFrameTable() const {
+	return binary_reader.isOpen() || compressed_reader.isOpen();
+}
+
+size_t IndexedFrameReader::getFrameCount() const {
+	if (binary_reader.isOpen()) {
+		return binary_reader.getFrameCount();
+	}
+	if (compressed_reader.isOpen()) {
+		return compressed_reader.getFrameCount();
+	}
+	return text_parser.getFrameCount();
+}
+
+long long IndexedFrameReader::getFrameNumber(size_t frame) const {
+	if (binary_reader.isOpen()) {
+		return binary_reader.getFrameNumber(frame);
+	}
+	if (compressed_reader.isOpen()) {
+		return compressed_reader.getFrameNumber(frame);
+	}
+	return text_parser.getFrameNumber(frame);
+}
+
+const vector<long long>& IndexedFrameReader::getFrameOffsets() const {
+	return text_parser.getFrameOffsets();
+}
+
+void IndexedFrameReader::readFrame(size_t frame, vector<SphParticle>& particles) {
+	if (binary_reader.isOpen()) {
+		binary_reader.readFrame(frame, particles);
+		return;
+	}
+	if (compressed_reader.isOpen()) {
+		compressed_reader.readFrame(frame, particles);
+		return;
+	}
+	if (text_parser.parseFrame(frame, particles) != 0) {
+		cout << "Malformed lines found in frame " << frame << ". Skipping...\n";
+	}
+}
+
+bool IndexedFrameReader::loadIndex(string indexFileName, vector<long long>& frame_offsets) {
+	ifstream index_file(indexFileName);
+	if (!index_file.is_open()) {
+		return false;
+	}
+
+	string line;
+	while (getline(index_file, line)) {
+		vector<string> splittedLine = split(line, '#');
+		if (splittedLine.size() != 3) {
+			return false;
+		}
+		frame_offsets.push_back(stoll(splittedLine.at(1), nullptr));
+	}
+	return true;
+}
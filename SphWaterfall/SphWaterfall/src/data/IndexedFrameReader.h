@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+
+#include "SphParticle.h"
+#include "ParticleIO.h"
+#include "BinaryFrameReader.h"
+#include "CompressedFrameReader.h"
+#include "TextFrameParser.h"
+
+using namespace std;
+// Reads single frames of a text, binary or compressed frame file through the byte offset of every frame.
+// Binary and compressed frame files carry the offsets in their frame table, for text files they are taken from the .idx file
+// next to them or found by scanning the mapped file for the frame headers
+class IndexedFrameReader {
+public:
+	IndexedFrameReader();
+	~IndexedFrameReader();
+	IndexedFrameReader(const IndexedFrameReader&) = delete;
+	IndexedFrameReader& operator=(const IndexedFrameReader&) = delete;
+
+	bool open(string fileName);
+	// text file whose frame offsets are already known, so the file doesn't have to be scanned again
+	bool open(string fileName, const vector<long long>& frame_offsets);
+	void close();
+
+	// binary and compressed frame files, every process can open them without being handed the offsets
+	bool hasFrameTable() const;
+	size_t getFrameCount() const;
+	// number of the frame at position frame, the simulation timestep it was written at
+	long long getFrameNumber(size_t frame) const;
+	// byte offsets of the frame headers of a text file
+	const vector<long long>& getFrameOffsets() const;
+	void readFrame(size_t frame, vector<SphParticle>& particles);
+
+private:
+	BinaryFrameReader binary_reader;
+	CompressedFrameReader compressed_reader;
+	TextFrameParser text_parser;
+
+	bool loadIndex(string indexFileName, vector<long long>& frame_offsets);
+};
@@ -0,0 +1,103 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile() :
+	data(nullptr),
+	size(0)
+{
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::isOpen() const {
+	return data != nullptr;
+}
+
+const char* MappedFile::getData() const {
+	return data;
+}
+
+size_t MappedFile::getSize() const {
+	return size;
+}
+
+#ifdef _WIN32
+bool MappedFile::open(std::string fileName) {
+	close();
+	file_handle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file_handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file_handle);
+		return false;
+	}
+	mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping_handle == NULL) {
+		CloseHandle(file_handle);
+		return false;
+	}
+	data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr) {
+		CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+		return false;
+	}
+	size = static_cast<size_t>(file_size.QuadPart);
+	return true;
+}
+
+void MappedFile::close() {
+	if (data == nullptr) {
+		return;
+	}
+	UnmapViewOfFile(data);
+	CloseHandle(mapping_handle);
+	CloseHandle(file_handle);
+	data = nullptr;
+	size = 0;
+}
+#else
+bool MappedFile::open(std::string fileName) {
+	close();
+	int file_descriptor = ::open(fileName.c_str(), O_RDONLY);
+	if (file_descriptor < 0) {
+		return false;
+	}
+	struct stat file_status;
+	if (fstat(file_descriptor, &file_status) != 0 || file_status.st_size == 0) {
+		::close(file_descriptor);
+		return false;
+	}
+	// the mapping stays valid after the descriptor is closed
+	void* mapping = mmap(nullptr, file_status.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	::close(file_descriptor);
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+	data = static_cast<const char*>(mapping);
+	size = static_cast<size_t>(file_status.st_size);
+	return true;
+}
+
+void MappedFile::close() {
+	if (data == nullptr) {
+		return;
+	}
+	munmap(const_cast<char*>(data), size);
+	data = nullptr;
+	size = 0;
+}
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+
+// A file mapped read-only into memory, the operating system pages it in on access
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(std::string fileName);
+	void close();
+	bool isOpen() const;
+
+	const char* getData() const;
+	size_t getSize() const;
+
+private:
+	const char* data;
+	size_t size;
+#ifdef _WIN32
+	void* file_handle;
+	void* mapping_handle;
+#endif
+};
@@ -0,0 +1,113 @@
+#include "ParallelParticleWriter.h"
+
+#include <cstdio>
+#include <cstring>
+
+ParallelParticleWriter::ParallelParticleWriter() :
+	is_open(false),
+	record_size(PARTICLE_RECORD_SIZE)
+{
+}
+
+ParallelParticleWriter::~ParallelParticleWriter() {
+
+}
+
+void ParallelParticleWriter::open(MPI_Comm comm, string fileName, bool with_ids) {
+	this->comm = comm;
+	MPI_Comm_rank(comm, &rank);
+	MPI_File_open(comm, fileName.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+	MPI_File_set_size(file, 0);
+	record_size = with_ids ? PARTICLE_RECORD_SIZE_WITH_ID : PARTICLE_RECORD_SIZE;
+	// the records are converted to little endian bytes before they are written
+	MPI_Type_contiguous(record_size * sizeof(double), MPI_BYTE, &record_datatype);
+	MPI_Type_commit(&record_datatype);
+	frame_offset = BINARY_FRAME_HEADER_SIZE;
+	frames.clear();
+
+	if (rank == 0) {
+		// completed by close, until then the index has the frames
+		char header[BINARY_FRAME_HEADER_SIZE] = {};
+		memcpy(header, BINARY_FRAME_MAGIC, 8);
+		BinaryFrameWriter::putUInt32(header + 8, BINARY_FRAME_VERSION);
+		BinaryFrameWriter::putUInt32(header + 12, record_size);
+		MPI_File_write_at(file, 0, header, BINARY_FRAME_HEADER_SIZE, MPI_BYTE, MPI_STATUS_IGNORE);
+
+		index_file_name = fileName + ".idx";
+		MPI_File_open(MPI_COMM_SELF, index_file_name.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &index_file);
+		MPI_File_set_size(index_file, 0);
+	}
+	is_open = true;
+}
+
+void ParallelParticleWriter::writeFrame(vector<SphParticle>& particles, long long frame_number) {
+	if (!is_open) {
+		return;
+	}
+
+	// where this process starts inside the frame
+	long long count = static_cast<long long>(particles.size());
+	long long count_before = 0;
+	long long total_count;
+	long long max_count;
+	MPI_Exscan(&count, &count_before, 1, MPI_LONG_LONG, MPI_SUM, comm);
+	if (rank == 0) {
+		count_before = 0;
+	}
+	MPI_Allreduce(&count, &total_count, 1, MPI_LONG_LONG, MPI_SUM, comm);
+	MPI_Allreduce(&count, &max_count, 1, MPI_LONG_LONG, MPI_MAX, comm);
+
+	MPI_Offset record_bytes = record_size * sizeof(double);
+	records.resize(particles.size() * record_bytes);
+	for (size_t i = 0; i < particles.size(); i++) {
+		BinaryFrameWriter::putRecord(records.data() + i * record_bytes, particles[i], record_size);
+	}
+
+	// collective calls must match, so every process writes as many chunks as the largest part needs
+	MPI_Offset offset = frame_offset + count_before * record_bytes;
+	long long written = 0;
+	do {
+		int chunk = static_cast<int>(std::min<long long>(count - written, MAX_PARTICLES_PER_MESSAGE));
+		MPI_File_write_at_all(file, offset + written * record_bytes, records.data() + written * record_bytes, chunk, record_datatype, MPI_STATUS_IGNORE);
+		written += chunk;
+		max_count -= MAX_PARTICLES_PER_MESSAGE;
+	} while (max_count > 0);
+
+	if (rank == 0) {
+		frames.push_back({ frame_number, static_cast<unsigned long long>(frame_offset), static_cast<unsigned long long>(total_count) });
+		char entry[BINARY_FRAME_TABLE_ENTRY_SIZE];
+		BinaryFrameWriter::putFrameEntry(entry, frame_number, frames.back().offset, frames.back().particle_count);
+		MPI_File_write_at(index_file, (frames.size() - 1) * BINARY_FRAME_TABLE_ENTRY_SIZE, entry, BINARY_FRAME_TABLE_ENTRY_SIZE, MPI_BYTE, MPI_STATUS_IGNORE);
+	}
+	frame_offset += total_count * record_bytes;
+}
+
+void ParallelParticleWriter::close() {
+	if (!is_open) {
+		return;
+	}
+	if (rank == 0) {
+		vector<char> table(frames.size() * BINARY_FRAME_TABLE_ENTRY_SIZE);
+		char* entry = table.data();
+		for (FrameEntry& each_frame : frames) {
+			BinaryFrameWriter::putFrameEntry(entry, each_frame.frame_number, each_frame.offset, each_frame.particle_count);
+			entry += BINARY_FRAME_TABLE_ENTRY_SIZE;
+		}
+		MPI_File_write_at(file, frame_offset, table.data(), static_cast<int>(table.size()), MPI_BYTE, MPI_STATUS_IGNORE);
+
+		char counts[16];
+		BinaryFrameWriter::putUInt64(counts, frames.size());
+		BinaryFrameWriter::putUInt64(counts + 8, static_cast<unsigned long long>(frame_offset));
+		MPI_File_write_at(file, 16, counts, 16, MPI_BYTE, MPI_STATUS_IGNORE);
+	}
+	MPI_File_close(&file);
+	MPI_Type_free(&record_datatype);
+	records = vector<char>();
+
+	// the table replaces the index
+	if (rank == 0) {
+		MPI_File_close(&index_file);
+		remove(index_file_name.c_str());
+	}
+	is_open = false;
+}
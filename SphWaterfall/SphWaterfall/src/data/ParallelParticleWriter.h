@@ -0,0 +1,44 @@
+#pragma once
+#include "mpi.h"
+#include <vector>
+#include <string>
+
+#include "SphParticle.h"
+#include "BinaryFrameWriter.h"
+
+using namespace std;
+// Every process writes its part of a frame into one shared file of the binary frame format with collective MPI-IO,
+// ordered by rank. The first process writes the header and keeps the frame table, which it writes on close
+// and appends to <fileName>.idx after every frame like BinaryFrameWriter, so the file is read like any other binary frame file
+class ParallelParticleWriter {
+public:
+	ParallelParticleWriter();
+	~ParallelParticleWriter();
+
+	// collective on comm, truncates an existing file, with_ids writes records of PARTICLE_RECORD_SIZE_WITH_ID
+	void open(MPI_Comm comm, string fileName, bool with_ids = false);
+	// collective, frame_number is the simulation timestep of the frame
+	void writeFrame(vector<SphParticle>& particles, long long frame_number);
+	// collective
+	void close();
+
+private:
+	struct FrameEntry {
+		long long frame_number;
+		unsigned long long offset;
+		unsigned long long particle_count;
+	};
+
+	bool is_open;
+	MPI_Comm comm;
+	int rank;
+	MPI_File file;
+	MPI_Datatype record_datatype;
+	int record_size;
+	MPI_Offset frame_offset;
+	vector<char> records;
+	// only on the first process
+	vector<FrameEntry> frames;
+	MPI_File index_file;
+	string index_file_name;
+};
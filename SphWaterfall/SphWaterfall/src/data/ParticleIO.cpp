@@ -1,31 +1,66 @@
 #include "ParticleIO.h"
 
+#include <cstring>
+
 using namespace std;
 
+// the appended raw data is written in the byte order of this machine
+static const char* getByteOrder() {
+	unsigned short probe = 1;
+	unsigned char first_byte;
+	memcpy(&first_byte, &probe, 1);
+	return (first_byte == 1) ? "LittleEndian" : "BigEndian";
+}
+
+// one block of appended raw data: the byte count as UInt64 followed by the values
+template<typename T>
+static void appendBlock(vector<char>& buffer, const vector<T>& values) {
+	unsigned long long byte_count = values.size() * sizeof(T);
+	size_t position = buffer.size();
+	buffer.resize(position + sizeof(byte_count) + byte_count);
+	memcpy(buffer.data() + position, &byte_count, sizeof(byte_count));
+	if (byte_count != 0) {
+		memcpy(buffer.data() + position + sizeof(byte_count), values.data(), byte_count);
+	}
+}
+
+static string getFileName(const string& path) {
+	size_t separator_position = path.find_last_of("/\\");
+	return (separator_position == string::npos) ? path : path.substr(separator_position + 1);
+}
+
 void ParticleIO::exportParticles(unordered_map<int, vector<SphParticle>>& frames, string fileName) {
 	ofstream file(fileName);
 	if (file.is_open())
 	{
 		for (int i = 1; i <= frames.size(); i++) {
-			file << "F#" << i << "#" << frames.size() << "\n";
-
-			for (int g = 0; g < frames.at(i).size(); g++) {
-				file << frames.at(i).at(g).position.x << "#"
-					<< frames.at(i).at(g).position.y << "#"
-					<< frames.at(i).at(g).position.z << "#"
-					<< frames.at(i).at(g).velocity.x << "#"
-					<< frames.at(i).at(g).velocity.y << "#"
-					<< frames.at(i).at(g).velocity.z << "#"
-					<< frames.at(i).at(g).mass << "\n";
-			}
+			writeFrame(file, frames.at(i), i, frames.size());
 		}
 		file.close();
 	}
 	else cout << "Unable to open file";
 }
 
+void ParticleIO::writeFrame(ostream& file, vector<SphParticle>& particles, int frame_number, int frame_count, bool with_ids) {
+	file << "F#" << frame_number << "#" << frame_count << "\n";
+
+	for (int g = 0; g < particles.size(); g++) {
+		file << particles.at(g).position.x << "#"
+			<< particles.at(g).position.y << "#"
+			<< particles.at(g).position.z << "#"
+			<< particles.at(g).velocity.x << "#"
+			<< particles.at(g).velocity.y << "#"
+			<< particles.at(g).velocity.z << "#"
+			<< particles.at(g).mass;
+		if (with_ids) {
+			file << "#" << particles.at(g).id;
+		}
+		file << "\n";
+	}
+}
+
 void ParticleIO::exportParticlesToVTK(vector<SphParticle>& particles, string name, int timestep,
-                                      vector<int> proc_boundaries) {
+                                      vector<long long> proc_boundaries, int fields) {
 	ofstream myfile;
 	std::ostringstream fileNameStream("");
 	fileNameStream << name << "_" << timestep << ".vtk";
@@ -39,41 +74,47 @@ void ParticleIO::exportParticlesToVTK(vector<SphParticle>& particles, string nam
 	myfile << "# vtk DataFile Version 3.0\n";
 	myfile << "vtk output\nASCII\nDATASET POLYDATA\n";
 
-	int count = particles.size();
+	size_t count = particles.size();
 
 	myfile << "POINTS " << count << " float\n";
 	for (auto& each_particle : particles) {
 		myfile << each_particle.position.x << " " << each_particle.position.y << " " << each_particle.position.z << "\n";
 	}
 	myfile << "VERTICES " << count << " " << count * 2 << "\n";
-	for (int i = 0; i < count; i++) {
+	for (size_t i = 0; i < count; i++) {
 		myfile << "1 " << i << "\n";
 	}
 	myfile << "POINT_DATA " << count << "\n";
-	myfile << "SCALARS Norm FLOAT" << "\n";
-	myfile << "LOOKUP_TABLE default" << "\n";
-	for (auto& each_particle : particles) {
-		myfile << each_particle.position.length() << "\n";
+	if (fields & OutputScheduler::NORM_FIELD) {
+		myfile << "SCALARS Norm FLOAT" << "\n";
+		myfile << "LOOKUP_TABLE default" << "\n";
+		for (auto& each_particle : particles) {
+			myfile << each_particle.position.length() << "\n";
+		}
 	}
 	//myfile << "POINT_DATA " << nodes << "\n";
-	myfile << "VECTORS Velocity FLOAT" << "\n";
-	myfile << "LOOKUP_TABLE default" << "\n";
-	for (auto& each_particle : particles) {
-		myfile << each_particle.velocity.x << " "
-               << each_particle.velocity.y << " "
-               << each_particle.velocity.z << "\n";
+	if (fields & OutputScheduler::VELOCITY_FIELD) {
+		myfile << "VECTORS Velocity FLOAT" << "\n";
+		myfile << "LOOKUP_TABLE default" << "\n";
+		for (auto& each_particle : particles) {
+			myfile << each_particle.velocity.x << " "
+				<< each_particle.velocity.y << " "
+				<< each_particle.velocity.z << "\n";
+		}
 	}
 
-	myfile << "SCALARS Density FLOAT" << "\n";
-	myfile << "LOOKUP_TABLE default" << "\n";
-	for (auto& each_particle : particles) {
-		myfile << each_particle.local_density << "\n";
+	if (fields & OutputScheduler::DENSITY_FIELD) {
+		myfile << "SCALARS Density FLOAT" << "\n";
+		myfile << "LOOKUP_TABLE default" << "\n";
+		for (auto& each_particle : particles) {
+			myfile << each_particle.local_density << "\n";
+		}
 	}
 
-    if (!proc_boundaries.empty()) {
+    if (!proc_boundaries.empty() && (fields & OutputScheduler::RANK_FIELD)) {
         myfile << "SCALARS MPI_Rank INT" << "\n";
         for (int p = 0; p < proc_boundaries.size(); ++p) {
-            for (int part = 0; part < proc_boundaries[p]; ++part) {
+            for (long long part = 0; part < proc_boundaries[p]; ++part) {
                 myfile << p << "\n";
             }
         }
@@ -82,54 +123,276 @@ void ParticleIO::exportParticlesToVTK(vector<SphParticle>& particles, string nam
 	myfile.close();
 }
 
+string ParticleIO::exportParticlesToVTU(vector<SphParticle>& particles, string name, int timestep,
+                                       vector<long long> proc_boundaries, int fields) {
+	if (proc_boundaries.empty()) {
+		proc_boundaries.push_back(static_cast<long long>(particles.size()));
+	}
+
+	vector<string> pieces;
+	long long offset = 0;
+	for (size_t p = 0; p < proc_boundaries.size(); p++) {
+		string pieceName = name + "_" + to_string(timestep) + "_" + to_string(p) + ".vtu";
+		exportPieceToVTU(particles.data() + offset, static_cast<size_t>(proc_boundaries[p]), pieceName, static_cast<int>(p), fields);
+		pieces.push_back(getFileName(pieceName));
+		offset += proc_boundaries[p];
+	}
+
+	string fileName = name + "_" + to_string(timestep) + ".pvtu";
+	exportPVTU(fileName, pieces, fields);
+	return getFileName(fileName);
+}
+
+void ParticleIO::exportPieceToVTU(const SphParticle* particles, size_t count, string fileName, int rank, int fields) {
+	ofstream myfile(fileName, ios::binary);
+	if (!myfile.is_open()) {
+		return;
+	}
+
+	// every array is one block of the appended data, the xml refers to it by its offset
+	vector<char> appended_data;
+	ostringstream data_arrays;
+	ostringstream point_arrays;
+
+	vector<float> points(3 * count);
+	for (size_t i = 0; i < count; i++) {
+		points[3 * i] = static_cast<float>(particles[i].position.x);
+		points[3 * i + 1] = static_cast<float>(particles[i].position.y);
+		points[3 * i + 2] = static_cast<float>(particles[i].position.z);
+	}
+	point_arrays << "      <DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << appended_data.size() << "\"/>\n";
+	appendBlock(appended_data, points);
+
+	if (fields & OutputScheduler::NORM_FIELD) {
+		vector<float> norms(count);
+		for (size_t i = 0; i < count; i++) {
+			norms[i] = static_cast<float>(particles[i].position.length());
+		}
+		data_arrays << "      <DataArray type=\"Float32\" Name=\"Norm\" format=\"appended\" offset=\"" << appended_data.size() << "\"/>\n";
+		appendBlock(appended_data, norms);
+	}
+	if (fields & OutputScheduler::VELOCITY_FIELD) {
+		vector<float> velocities(3 * count);
+		for (size_t i = 0; i < count; i++) {
+			velocities[3 * i] = static_cast<float>(particles[i].velocity.x);
+			velocities[3 * i + 1] = static_cast<float>(particles[i].velocity.y);
+			velocities[3 * i + 2] = static_cast<float>(particles[i].velocity.z);
+		}
+		data_arrays << "      <DataArray type=\"Float32\" Name=\"Velocity\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << appended_data.size() << "\"/>\n";
+		appendBlock(appended_data, velocities);
+	}
+	if (fields & OutputScheduler::DENSITY_FIELD) {
+		vector<float> densities(count);
+		for (size_t i = 0; i < count; i++) {
+			densities[i] = static_cast<float>(particles[i].local_density);
+		}
+		data_arrays << "      <DataArray type=\"Float32\" Name=\"Density\" format=\"appended\" offset=\"" << appended_data.size() << "\"/>\n";
+		appendBlock(appended_data, densities);
+	}
+	if (fields & OutputScheduler::RANK_FIELD) {
+		data_arrays << "      <DataArray type=\"Int32\" Name=\"MPI_Rank\" format=\"appended\" offset=\"" << appended_data.size() << "\"/>\n";
+		appendBlock(appended_data, vector<int>(count, rank));
+	}
+
+	// one vertex cell per particle
+	vector<long long> connectivity(count);
+	vector<long long> offsets(count);
+	for (size_t i = 0; i < count; i++) {
+		connectivity[i] = static_cast<long long>(i);
+		offsets[i] = static_cast<long long>(i + 1);
+	}
+	ostringstream cell_arrays;
+	cell_arrays << "      <DataArray type=\"Int64\" Name=\"connectivity\" format=\"appended\" offset=\"" << appended_data.size() << "\"/>\n";
+	appendBlock(appended_data, connectivity);
+	cell_arrays << "      <DataArray type=\"Int64\" Name=\"offsets\" format=\"appended\" offset=\"" << appended_data.size() << "\"/>\n";
+	appendBlock(appended_data, offsets);
+	cell_arrays << "      <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"" << appended_data.size() << "\"/>\n";
+	appendBlock(appended_data, vector<unsigned char>(count, 1));
+
+	myfile << "<?xml version=\"1.0\"?>\n";
+	myfile << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" << getByteOrder() << "\" header_type=\"UInt64\">\n";
+	myfile << "  <UnstructuredGrid>\n";
+	myfile << "    <Piece NumberOfPoints=\"" << count << "\" NumberOfCells=\"" << count << "\">\n";
+	myfile << "     <PointData>\n" << data_arrays.str() << "     </PointData>\n";
+	myfile << "     <Points>\n" << point_arrays.str() << "     </Points>\n";
+	myfile << "     <Cells>\n" << cell_arrays.str() << "     </Cells>\n";
+	myfile << "    </Piece>\n";
+	myfile << "  </UnstructuredGrid>\n";
+	myfile << "  <AppendedData encoding=\"raw\">\n_";
+	myfile.write(appended_data.data(), appended_data.size());
+	myfile << "\n  </AppendedData>\n";
+	myfile << "</VTKFile>\n";
+
+	myfile.close();
+}
+
+void ParticleIO::exportPVTU(string fileName, vector<string>& pieces, int fields) {
+	ofstream myfile(fileName);
+	if (!myfile.is_open()) {
+		return;
+	}
+
+	myfile << "<?xml version=\"1.0\"?>\n";
+	myfile << "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\" byte_order=\"" << getByteOrder() << "\" header_type=\"UInt64\">\n";
+	myfile << "  <PUnstructuredGrid GhostLevel=\"0\">\n";
+	myfile << "    <PPointData>\n";
+	if (fields & OutputScheduler::NORM_FIELD) {
+		myfile << "      <PDataArray type=\"Float32\" Name=\"Norm\"/>\n";
+	}
+	if (fields & OutputScheduler::VELOCITY_FIELD) {
+		myfile << "      <PDataArray type=\"Float32\" Name=\"Velocity\" NumberOfComponents=\"3\"/>\n";
+	}
+	if (fields & OutputScheduler::DENSITY_FIELD) {
+		myfile << "      <PDataArray type=\"Float32\" Name=\"Density\"/>\n";
+	}
+	if (fields & OutputScheduler::RANK_FIELD) {
+		myfile << "      <PDataArray type=\"Int32\" Name=\"MPI_Rank\"/>\n";
+	}
+	myfile << "    </PPointData>\n";
+	myfile << "    <PPoints>\n";
+	myfile << "      <PDataArray type=\"Float32\" NumberOfComponents=\"3\"/>\n";
+	myfile << "    </PPoints>\n";
+	for (string& each_piece : pieces) {
+		myfile << "    <Piece Source=\"" << each_piece << "\"/>\n";
+	}
+	myfile << "  </PUnstructuredGrid>\n";
+	myfile << "</VTKFile>\n";
+
+	myfile.close();
+}
+
+void ParticleIO::exportPVD(string fileName, vector<pair<double, string>>& datasets) {
+	ofstream myfile(fileName);
+	if (!myfile.is_open()) {
+		return;
+	}
+
+	myfile << "<?xml version=\"1.0\"?>\n";
+	myfile << "<VTKFile type=\"Collection\" version=\"0.1\" byte_order=\"" << getByteOrder() << "\">\n";
+	myfile << "  <Collection>\n";
+	for (auto& each_dataset : datasets) {
+		myfile << "    <DataSet timestep=\"" << each_dataset.first << "\" group=\"\" part=\"0\" file=\"" << each_dataset.second << "\"/>\n";
+	}
+	myfile << "  </Collection>\n";
+	myfile << "</VTKFile>\n";
+
+	myfile.close();
+}
+
 vector<vector<SphParticle>> ParticleIO::importParticles(string fileName) {
 	vector<vector<SphParticle>> frames;
 
-	string line;
-	ifstream myfile(fileName);
-	if (myfile.is_open())
-	{
-		int counter = 0;
-		vector<SphParticle> frame;
-		while (getline(myfile, line))
-		{
-			if (startsWith(line, "F")) {
-				counter++;
-				if (!frame.empty()) 
-				{
-					frames.emplace_back(frame);
-					frame.clear();
-				}
-				continue;
+	if (BinaryFrameReader::isBinaryFrameFile(fileName)) {
+		BinaryFrameReader reader;
+		if (reader.open(fileName)) {
+			frames.resize(reader.getFrameCount());
+			for (size_t i = 0; i < reader.getFrameCount(); i++) {
+				reader.readFrame(i, frames[i]);
+			}
+			cout << "Found " << frames.size() << " frames in file.\n";
+		}
+		return frames;
+	}
+	if (CompressedFrameReader::isCompressedFrameFile(fileName)) {
+		CompressedFrameReader reader;
+		if (reader.open(fileName)) {
+			frames.resize(reader.getFrameCount());
+			for (size_t i = 0; i < reader.getFrameCount(); i++) {
+				reader.readFrame(i, frames[i]);
 			}
+			cout << "Found " << frames.size() << " frames in file.\n";
+		}
+		return frames;
+	}
 
-			vector<string> splittedLine = split(line, '#');
+	TextFrameParser parser;
+	if (parser.open(fileName)) {
+		frames.resize(parser.getFrameCount());
+		if (parser.parseFrames(0, frames) != 0) {
+			cout << "Malformed lines found. Skipping...\n";
+		}
+		cout << "Found " << frames.size() << " frames in file.\n";
+	}
 
-			if (splittedLine.size() != 7) {
-				cout << "Malformed line found at " << counter << ". Skipping...\n";
-				continue;
-			}
+	return frames;
+}
+
+bool ParticleIO::convertTextToBinary(string textFileName, string binaryFileName) {
+	return TextFrameParser::convertToBinary(textFileName, binaryFileName);
+}
+
+bool ParticleIO::convertBinaryToText(string binaryFileName, string textFileName) {
+	BinaryFrameReader reader;
+	CompressedFrameReader compressed_reader;
+	bool is_compressed = CompressedFrameReader::isCompressedFrameFile(binaryFileName);
+	if (is_compressed ? !compressed_reader.open(binaryFileName) : !reader.open(binaryFileName)) {
+		return false;
+	}
+	ofstream text_file(textFileName);
+	if (!text_file.is_open()) {
+		cout << "Unable to open file";
+		return false;
+	}
 
-			frame.emplace_back(SphParticle(
-				Vector3(
-					stod(splittedLine.at(0), nullptr),
-					stod(splittedLine.at(1), nullptr),
-					stod(splittedLine.at(2), nullptr)
-				),
-				Vector3(
-					stod(splittedLine.at(3), nullptr),
-					stod(splittedLine.at(4), nullptr),
-					stod(splittedLine.at(5), nullptr)
-				),
-				stod(splittedLine.at(6), nullptr)
-			));
+	vector<SphParticle> frame;
+	size_t frame_count = is_compressed ? compressed_reader.getFrameCount() : reader.getFrameCount();
+	for (size_t i = 0; i < frame_count; i++) {
+		if (is_compressed) {
+			compressed_reader.readFrame(i, frame);
+		}
+		else {
+			reader.readFrame(i, frame);
 		}
-		frames.emplace_back(frame);
-		myfile.close();
-		cout << "Found " << counter << " frames in file.\n";
+		long long frame_number = is_compressed ? compressed_reader.getFrameNumber(i) : reader.getFrameNumber(i);
+		// compressed frames keep the ids the particles had when they were written
+		bool with_ids = is_compressed ? (!frame.empty() && frame.front().id != 0) : reader.hasIds();
+		writeFrame(text_file, frame, static_cast<int>(frame_number), static_cast<int>(frame_count), with_ids);
+	}
+	text_file.close();
+	return true;
+}
+
+bool ParticleIO::compressFrames(string fileName, string compressedFileName, double tolerance) {
+	if (!BinaryFrameReader::isBinaryFrameFile(fileName)) {
+		return TextFrameParser::convertToCompressed(fileName, compressedFileName, tolerance);
 	}
 
-	else cout << "Unable to open file";
+	BinaryFrameReader reader;
+	CompressedFrameWriter writer;
+	if (!reader.open(fileName) || !writer.open(compressedFileName, tolerance)) {
+		return false;
+	}
+	vector<SphParticle> frame;
+	for (size_t i = 0; i < reader.getFrameCount(); i++) {
+		reader.readFrame(i, frame);
+		writer.appendFrame(frame, reader.getFrameNumber(i));
+	}
+	writer.close();
+	return true;
+}
 
-	return frames;
-}
\ No newline at end of file
+bool ParticleIO::parseParticle(const string& line, vector<SphParticle>& particles) {
+	vector<string> splittedLine = split(line, '#');
+
+	if (splittedLine.size() != 7 && splittedLine.size() != 8) {
+		return false;
+	}
+
+	particles.emplace_back(SphParticle(
+		Vector3(
+			stod(splittedLine.at(0), nullptr),
+			stod(splittedLine.at(1), nullptr),
+			stod(splittedLine.at(2), nullptr)
+		),
+		Vector3(
+			stod(splittedLine.at(3), nullptr),
+			stod(splittedLine.at(4), nullptr),
+			stod(splittedLine.at(5), nullptr)
+		),
+		stod(splittedLine.at(6), nullptr)
+	));
+	if (splittedLine.size() == 8) {
+		particles.back().id = stoull(splittedLine.at(7), nullptr);
+	}
+	return true;
+}
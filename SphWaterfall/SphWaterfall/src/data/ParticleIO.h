@@ -8,6 +8,12 @@
 #include <math.h>
 
 #include "SphParticle.h"
+#include "BinaryFrameReader.h"
+#include "BinaryFrameWriter.h"
+#include "CompressedFrameReader.h"
+#include "CompressedFrameWriter.h"
+#include "TextFrameParser.h"
+#include "../simulation/OutputScheduler.h"
 #include "../visualization/util.h"
 
 using namespace std;
@@ -16,9 +22,37 @@ public:
 	//Exportiert die Partikel als Datei
 	static void exportParticles(unordered_map<int, vector<SphParticle>>& frames, string fileName);
 
+	//Schreibt einen Frame im Format von exportParticles, mit with_ids bekommt jede Zeile die Partikel-ID als achtes Feld
+	static void writeFrame(ostream& file, vector<SphParticle>& particles, int frame_number, int frame_count, bool with_ids = false);
+
 	//Exportiert die Partikel im VTK-Format
-	static void exportParticlesToVTK(vector<SphParticle>& particles, string fileName, int timestep, vector<int> proc_boundaries = {});
+	static void exportParticlesToVTK(vector<SphParticle>& particles, string fileName, int timestep, vector<long long> proc_boundaries = {}, int fields = OutputScheduler::ALL_FIELDS);
+
+	//Exportiert die Partikel als binaere VTU-Dateien, eine pro Prozess, und eine PVTU-Datei die sie zusammenfasst.
+	//Gibt den Namen der PVTU-Datei relativ zu ihrem Verzeichnis zurueck
+	static string exportParticlesToVTU(vector<SphParticle>& particles, string fileName, int timestep, vector<long long> proc_boundaries = {}, int fields = OutputScheduler::ALL_FIELDS);
+
+	//Exportiert die Partikel eines Prozesses als VTU-Datei mit angehaengten Rohdaten
+	static void exportPieceToVTU(const SphParticle* particles, size_t count, string fileName, int rank, int fields = OutputScheduler::ALL_FIELDS);
+
+	//Schreibt eine PVTU-Datei, die die VTU-Dateien der Prozesse zusammenfasst
+	static void exportPVTU(string fileName, vector<string>& pieces, int fields = OutputScheduler::ALL_FIELDS);
+
+	//Schreibt eine PVD-Zeitreihe aus Paaren von Zeit und Datei
+	static void exportPVD(string fileName, vector<pair<double, string>>& datasets);
 
-	//Importiert die Partikel aus Datei
+	//Importiert die Partikel aus Datei, als Text, im binaeren oder im komprimierten Frame-Format
 	static vector<vector<SphParticle>> importParticles(string fileName);
+
+	//Wandelt eine Textdatei mit mehreren Threads in das binaere Frame-Format um
+	static bool convertTextToBinary(string textFileName, string binaryFileName);
+
+	//Wandelt eine Datei im binaeren oder komprimierten Frame-Format in das Textformat um
+	static bool convertBinaryToText(string binaryFileName, string textFileName);
+
+	//Komprimiert eine Textdatei oder eine Datei im binaeren Frame-Format mit der gegebenen relativen Toleranz
+	static bool compressFrames(string fileName, string compressedFileName, double tolerance);
+
+	//Liest eine Partikelzeile "x#y#z#vx#vy#vz#mass" oder "x#y#z#vx#vy#vz#mass#id" und haengt das Partikel an
+	static bool parseParticle(const string& line, vector<SphParticle>& particles);
 };
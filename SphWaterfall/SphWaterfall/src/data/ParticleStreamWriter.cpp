@@ -0,0 +1,58 @@
+#include "ParticleStreamWriter.h"
+
+ParticleStreamWriter::ParticleStreamWriter(string fileName, int frame_count, Format format, double tolerance, bool with_ids) :
+	format(format),
+	with_ids(with_ids),
+	frame_count(frame_count)
+{
+	if (format == BINARY_FORMAT) {
+		binary_writer.open(fileName, with_ids);
+		return;
+	}
+	if (format == COMPRESSED_FORMAT) {
+		compressed_writer.open(fileName, tolerance);
+		return;
+	}
+	file.open(fileName);
+	index_file.open(fileName + ".idx");
+	if (!file.is_open() || !index_file.is_open()) {
+		cout << "Unable to open file";
+	}
+}
+
+ParticleStreamWriter::~ParticleStreamWriter() {
+	close();
+}
+
+void ParticleStreamWriter::appendFrame(vector<SphParticle>& particles, long long frame_number) {
+	if (format == BINARY_FORMAT) {
+		binary_writer.appendFrame(particles, frame_number);
+		return;
+	}
+	if (format == COMPRESSED_FORMAT) {
+		compressed_writer.appendFrame(particles, frame_number);
+		return;
+	}
+	if (!file.is_open()) {
+		return;
+	}
+
+	long long offset = static_cast<long long>(file.tellp());
+	ParticleIO::writeFrame(file, particles, static_cast<int>(frame_number), frame_count, with_ids);
+	// a crashed run keeps every frame up to the last one
+	file.flush();
+
+	index_file << frame_number << "#" << offset << "#" << particles.size() << "\n";
+	index_file.flush();
+}
+
+void ParticleStreamWriter::close() {
+	binary_writer.close();
+	compressed_writer.close();
+	if (file.is_open()) {
+		file.close();
+	}
+	if (index_file.is_open()) {
+		index_file.close();
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+
+#include "SphParticle.h"
+#include "ParticleIO.h"
+#include "BinaryFrameWriter.h"
+#include "CompressedFrameWriter.h"
+
+using namespace std;
+// Appends frames to a particle file as they arrive, so only one frame is held in memory.
+// Next to a text file an index with one line "frame#byte offset#particle count" per frame is kept up to date,
+// binary and compressed frame files carry their own frame table
+class ParticleStreamWriter {
+public:
+	enum Format
+	{
+		TEXT_FORMAT,
+		BINARY_FORMAT,
+		COMPRESSED_FORMAT
+	};
+
+	// tolerance of the compressed format relative to the bounding box of a frame, with_ids adds the particle ids
+	// to text and binary frames, compressed frames always code them
+	ParticleStreamWriter(string fileName, int frame_count, Format format = TEXT_FORMAT, double tolerance = FRAME_CODEC_TOLERANCE, bool with_ids = false);
+	~ParticleStreamWriter();
+
+	// frame_number is the simulation timestep of the frame, the renderer compares it with the shutter timestep
+	void appendFrame(vector<SphParticle>& particles, long long frame_number);
+	void close();
+
+private:
+	ofstream file;
+	ofstream index_file;
+	BinaryFrameWriter binary_writer;
+	CompressedFrameWriter compressed_writer;
+	Format format;
+	bool with_ids;
+	int frame_count;
+};
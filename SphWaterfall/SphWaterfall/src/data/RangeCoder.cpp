@@ -0,0 +1,165 @@
+#include "RangeCoder.h"
+
+RangeEncoder::RangeEncoder(vector<char>& buffer, int context_count) :
+	buffer(buffer),
+	low(0),
+	range(0xFFFFFFFFu),
+	cache(0),
+	cache_size(1),
+	probabilities(static_cast<size_t>(context_count) * RANGE_CODER_BUCKET_TREE_SIZE, 1 << (RANGE_CODER_PROBABILITY_BITS - 1))
+{
+}
+
+RangeEncoder::~RangeEncoder() {
+
+}
+
+void RangeEncoder::encodeBit(unsigned short& probability, int bit) {
+	unsigned int bound = (range >> RANGE_CODER_PROBABILITY_BITS) * probability;
+	if (bit == 0) {
+		range = bound;
+		probability += ((1 << RANGE_CODER_PROBABILITY_BITS) - probability) >> RANGE_CODER_ADAPTION_SHIFT;
+	}
+	else {
+		low += bound;
+		range -= bound;
+		probability -= probability >> RANGE_CODER_ADAPTION_SHIFT;
+	}
+	while (range < RANGE_CODER_TOP_VALUE) {
+		range <<= 8;
+		shiftLow();
+	}
+}
+
+void RangeEncoder::encodeDirectBits(unsigned long long value, int bit_count) {
+	for (int i = bit_count - 1; i >= 0; i--) {
+		range >>= 1;
+		if ((value >> i) & 1) {
+			low += range;
+		}
+		while (range < RANGE_CODER_TOP_VALUE) {
+			range <<= 8;
+			shiftLow();
+		}
+	}
+}
+
+void RangeEncoder::encodeValue(int context, unsigned long long value) {
+	// bucket k holds the values whose successor has its highest set bit at k
+	unsigned long long successor = value + 1;
+	int bucket = 0;
+	while ((successor >> bucket) > 1) {
+		bucket++;
+	}
+
+	unsigned short* tree = probabilities.data() + static_cast<size_t>(context) * RANGE_CODER_BUCKET_TREE_SIZE;
+	int node = 1;
+	for (int i = 5; i >= 0; i--) {
+		int bit = (bucket >> i) & 1;
+		encodeBit(tree[node], bit);
+		node = (node << 1) | bit;
+	}
+	encodeDirectBits(successor, bucket);
+}
+
+void RangeEncoder::flush() {
+	for (int i = 0; i < 5; i++) {
+		shiftLow();
+	}
+}
+
+void RangeEncoder::shiftLow() {
+	// a carry out of the low 32 bits still has to reach the bytes held back in the cache
+	if (static_cast<unsigned int>(low) < 0xFF000000u || (low >> 32) != 0) {
+		unsigned char carry = static_cast<unsigned char>(low >> 32);
+		unsigned char pending = cache;
+		do {
+			buffer.push_back(static_cast<char>(static_cast<unsigned char>(pending + carry)));
+			pending = 0xFF;
+		} while (--cache_size != 0);
+		cache = static_cast<unsigned char>(low >> 24);
+	}
+	cache_size++;
+	low = (low & 0x00FFFFFFu) << 8;
+}
+
+RangeDecoder::RangeDecoder(const char* data, size_t size, int context_count) :
+	data(data),
+	size(size),
+	position(0),
+	code(0),
+	range(0xFFFFFFFFu),
+	is_overrun(false),
+	probabilities(static_cast<size_t>(context_count) * RANGE_CODER_BUCKET_TREE_SIZE, 1 << (RANGE_CODER_PROBABILITY_BITS - 1))
+{
+	for (int i = 0; i < 5; i++) {
+		code = (code << 8) | nextByte();
+	}
+}
+
+RangeDecoder::~RangeDecoder() {
+
+}
+
+int RangeDecoder::decodeBit(unsigned short& probability) {
+	unsigned int bound = (range >> RANGE_CODER_PROBABILITY_BITS) * probability;
+	int bit;
+	if (code < bound) {
+		range = bound;
+		probability += ((1 << RANGE_CODER_PROBABILITY_BITS) - probability) >> RANGE_CODER_ADAPTION_SHIFT;
+		bit = 0;
+	}
+	else {
+		code -= bound;
+		range -= bound;
+		probability -= probability >> RANGE_CODER_ADAPTION_SHIFT;
+		bit = 1;
+	}
+	while (range < RANGE_CODER_TOP_VALUE) {
+		range <<= 8;
+		code = (code << 8) | nextByte();
+	}
+	return bit;
+}
+
+unsigned long long RangeDecoder::decodeDirectBits(int bit_count) {
+	unsigned long long value = 0;
+	for (int i = 0; i < bit_count; i++) {
+		range >>= 1;
+		int bit = 0;
+		if (code >= range) {
+			code -= range;
+			bit = 1;
+		}
+		value = (value << 1) | bit;
+		while (range < RANGE_CODER_TOP_VALUE) {
+			range <<= 8;
+			code = (code << 8) | nextByte();
+		}
+	}
+	return value;
+}
+
+unsigned long long RangeDecoder::decodeValue(int context) {
+	unsigned short* tree = probabilities.data() + static_cast<size_t>(context) * RANGE_CODER_BUCKET_TREE_SIZE;
+	int node = 1;
+	for (int i = 0; i < 6; i++) {
+		node = (node << 1) | decodeBit(tree[node]);
+	}
+	int bucket = node - RANGE_CODER_BUCKET_TREE_SIZE;
+
+	unsigned long long successor = (1ull << bucket) | decodeDirectBits(bucket);
+	return successor - 1;
+}
+
+bool RangeDecoder::isOverrun() const {
+	return is_overrun;
+}
+
+unsigned char RangeDecoder::nextByte() {
+	if (position >= size) {
+		is_overrun = true;
+		return 0;
+	}
+	return static_cast<unsigned char>(data[position++]);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+// probabilities of a 0 bit as fixed point numbers with 11 bits, adapted by 1/32 of the distance per coded bit
+#define RANGE_CODER_PROBABILITY_BITS 11
+#define RANGE_CODER_ADAPTION_SHIFT 5
+// the range is renormalised by a byte whenever it falls below 2^24
+#define RANGE_CODER_TOP_VALUE (1u << 24)
+// probabilities of the bit tree of the exp-Golomb bucket of a value, per context
+#define RANGE_CODER_BUCKET_TREE_SIZE 64
+
+using namespace std;
+// Adaptive binary range coder in the way of LZMA. An integer is coded as its exp-Golomb bucket through a bit tree
+// of adaptive probabilities, one tree per context, followed by the remaining bits of the bucket at even odds
+class RangeEncoder {
+public:
+	// appends the coded bytes to buffer
+	RangeEncoder(vector<char>& buffer, int context_count);
+	~RangeEncoder();
+
+	void encodeBit(unsigned short& probability, int bit);
+	void encodeDirectBits(unsigned long long value, int bit_count);
+	// any value but the largest unsigned long long
+	void encodeValue(int context, unsigned long long value);
+	// writes the last bytes, nothing can be encoded afterwards
+	void flush();
+
+private:
+	vector<char>& buffer;
+	unsigned long long low;
+	unsigned int range;
+	unsigned char cache;
+	unsigned long long cache_size;
+	vector<unsigned short> probabilities;
+
+	void shiftLow();
+};
+
+class RangeDecoder {
+public:
+	RangeDecoder(const char* data, size_t size, int context_count);
+	~RangeDecoder();
+
+	int decodeBit(unsigned short& probability);
+	unsigned long long decodeDirectBits(int bit_count);
+	unsigned long long decodeValue(int context);
+	// more bytes were needed than the data has, the decoded values are garbage
+	bool isOverrun() const;
+
+private:
+	const char* data;
+	size_t size;
+	size_t position;
+	unsigned int code;
+	unsigned int range;
+	bool is_overrun;
+	vector<unsigned short> probabilities;
+
+	unsigned char nextByte();
+};
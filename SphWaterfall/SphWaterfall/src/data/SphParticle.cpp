@@ -6,6 +6,8 @@ SphParticle::SphParticle() :
 	particle_type(SphParticle::ParticleType::FLUID) {
 	this->mass = FLUID_MASS;
 	this->local_density = FLUID_REFERENCE_DENSITY;
+	this->id = 0;
+	this->is_surface = true;
 }
 
 SphParticle::SphParticle(Vector3 position) :
@@ -14,7 +16,8 @@ SphParticle::SphParticle(Vector3 position) :
 	particle_type(SphParticle::ParticleType::FLUID) {
 	this->mass = FLUID_MASS;
 	this->local_density = FLUID_REFERENCE_DENSITY;
-
+	this->id = 0;
+	this->is_surface = true;
 }
 
 SphParticle::SphParticle(Vector3 position, Vector3 velocity) :
@@ -23,6 +26,8 @@ SphParticle::SphParticle(Vector3 position, Vector3 velocity) :
 	particle_type(SphParticle::ParticleType::FLUID) {
 	this->mass = FLUID_MASS;
 	this->local_density = FLUID_REFERENCE_DENSITY;
+	this->id = 0;
+	this->is_surface = true;
 }
 
 SphParticle::SphParticle(Vector3 position, Vector3 velocity, double mass) :
@@ -31,6 +36,8 @@ SphParticle::SphParticle(Vector3 position, Vector3 velocity, double mass) :
 	mass(mass),
 	particle_type(SphParticle::ParticleType::FLUID) {
 	this->local_density = FLUID_REFERENCE_DENSITY;
+	this->id = 0;
+	this->is_surface = true;
 }
 
 SphParticle::SphParticle(Vector3 position, SphParticle::ParticleType particle_type) :
@@ -45,6 +52,8 @@ SphParticle::SphParticle(Vector3 position, SphParticle::ParticleType particle_ty
 		this->mass = FLUID_MASS;
 		this->local_density = FLUID_REFERENCE_DENSITY;
 	}
+	this->id = 0;
+	this->is_surface = true;
 }
 
 SphParticle::~SphParticle() {
@@ -61,4 +70,16 @@ std::ostream& operator<<(std::ostream& out, const SphParticle& particle) {
 
 SphParticle::ParticleType SphParticle::getParticleType() const {
 	return this->particle_type;
+}
+
+bool SphParticle::isSurface() const {
+	return this->is_surface;
+}
+
+void SphParticle::setSurface(bool is_surface) {
+	this->is_surface = is_surface;
+}
+
+bool SphParticle::isInteriorCell() const {
+	return (this->id & INTERIOR_CELL_ID_FLAG) != 0;
 }
\ No newline at end of file
@@ -26,8 +26,17 @@ class SphParticle {
 		Vector3 velocity;
 		double mass;
 		double local_density;
+		// unique over all processes, 0 if the particle has none
+		unsigned long long id;
 
 		ParticleType getParticleType() const;
+		// near the free surface at the last classification, unclassified particles count as surface
+		bool isSurface() const;
+		void setSurface(bool is_surface);
+		// stands for the interior particles of a neighbour search cell in a surface-only export
+		bool isInteriorCell() const;
 	private:
 		ParticleType particle_type;
+		// in the padding after particle_type, particles keep their size
+		bool is_surface;
 };
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "TextFrameParser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+TextFrameParser::TextFrameParser() :
+	thread_count(1)
+{
+}
+
+TextFrameParser::~TextFrameParser() {
+	close();
+}
+
+bool TextFrameParser::open(string fileName, int thread_count) {
+	close();
+	this->thread_count = (thread_count > 0) ? thread_count : std::max(1u, std::thread::hardware_concurrency());
+	if (!file.open(fileName)) {
+		cout << "Unable to open file " << fileName << "\n";
+		return false;
+	}
+	findFrames();
+	return true;
+}
+
+bool TextFrameParser::open(string fileName, const vector<long long>& frame_offsets, int thread_count) {
+	close();
+	this->thread_count = (thread_count > 0) ? thread_count : std::max(1u, std::thread::hardware_concurrency());
+	if (!file.open(fileName)) {
+		cout << "Unable to open file " << fileName << "\n";
+		return false;
+	}
+
+	const char* data = file.getData();
+	long long size = static_cast<long long>(file.getSize());
+	long long previous_offset = -1;
+	for (long long each_offset : frame_offsets) {
+		if (each_offset <= previous_offset || each_offset >= size || data[each_offset] != 'F' || (each_offset != 0 && data[each_offset - 1] != '\n')) {
+			close();
+			return false;
+		}
+		previous_offset = each_offset;
+	}
+	this->frame_offsets = frame_offsets;
+	return true;
+}
+
+void TextFrameParser::close() {
+	file.close();
+	frame_offsets.clear();
+}
+
+bool TextFrameParser::isOpen() const {
+	return file.isOpen();
+}
+
+size_t TextFrameParser::getFrameCount() const {
+	return frame_offsets.size();
+}
+
+const vector<long long>& TextFrameParser::getFrameOffsets() const {
+	return frame_offsets;
+}
+
+long long TextFrameParser::getFrameNumber(size_t frame) const {
+	const char* header = file.getData() + frame_offsets.at(frame);
+	const char* end = file.getData() + file.getSize();
+	long long frame_number;
+	if (header + 2 < end && header[1] == '#' && std::from_chars(header + 2, end, frame_number).ec == std::errc()) {
+		return frame_number;
+	}
+	return static_cast<long long>(frame) + 1;
+}
+
+long long TextFrameParser::parseFrame(size_t frame, vector<SphParticle>& particles) const {
+	particles.clear();
+	const char* data = file.getData();
+	const char* position = data + frame_offsets.at(frame);
+	const char* end = data + ((frame + 1 < frame_offsets.size()) ? frame_offsets[frame + 1] : file.getSize());
+
+	// skip the header line
+	const char* header_end = static_cast<const char*>(memchr(position, '\n', end - position));
+	position = (header_end == nullptr) ? end : header_end + 1;
+
+	long long malformed_lines = 0;
+	while (position < end) {
+		const char* line_end = static_cast<const char*>(memchr(position, '\n', end - position));
+		if (line_end == nullptr) {
+			line_end = end;
+		}
+		if (!parseLine(position, line_end, particles)) {
+			malformed_lines++;
+		}
+		position = line_end + 1;
+	}
+	return malformed_lines;
+}
+
+long long TextFrameParser::parseFrames(size_t first_frame, vector<vector<SphParticle>>& frames) const {
+	// every thread takes the next unparsed frame, so long frames don't hold up the others
+	std::atomic<size_t> next_frame(0);
+	std::atomic<long long> malformed_lines(0);
+	auto parse = [&]() {
+		size_t frame;
+		while ((frame = next_frame++) < frames.size()) {
+			malformed_lines += parseFrame(first_frame + frame, frames[frame]);
+		}
+	};
+
+	vector<std::thread> threads;
+	size_t parser_count = std::min(static_cast<size_t>(thread_count), frames.size());
+	for (size_t i = 1; i < parser_count; i++) {
+		threads.emplace_back(parse);
+	}
+	parse();
+	for (std::thread& each_thread : threads) {
+		each_thread.join();
+	}
+	return malformed_lines;
+}
+
+bool TextFrameParser::convertToBinary(string textFileName, string binaryFileName, int thread_count) {
+	BinaryFrameWriter writer;
+	if (!writer.open(binaryFileName, hasIds(textFileName))) {
+		return false;
+	}
+	return convert(textFileName, [&writer](vector<SphParticle>& frame, long long frame_number) { writer.appendFrame(frame, frame_number); }, thread_count);
+}
+
+bool TextFrameParser::convertToCompressed(string textFileName, string compressedFileName, double tolerance, int thread_count) {
+	CompressedFrameWriter writer;
+	if (!writer.open(compressedFileName, tolerance)) {
+		return false;
+	}
+	return convert(textFileName, [&writer](vector<SphParticle>& frame, long long frame_number) { writer.appendFrame(frame, frame_number); }, thread_count);
+}
+
+bool TextFrameParser::convert(string textFileName, function<void(vector<SphParticle>&, long long)> appendFrame, int thread_count) {
+	TextFrameParser parser;
+	if (!parser.open(textFileName, thread_count)) {
+		return false;
+	}
+
+	// batches of two frames per thread are parsed in parallel and written in order, only one batch is held in memory
+	vector<vector<SphParticle>> frames;
+	long long malformed_lines = 0;
+	for (size_t first_frame = 0; first_frame < parser.getFrameCount(); first_frame += frames.size()) {
+		frames.resize(std::min(static_cast<size_t>(2 * parser.thread_count), parser.getFrameCount() - first_frame));
+		malformed_lines += parser.parseFrames(first_frame, frames);
+		for (size_t i = 0; i < frames.size(); i++) {
+			appendFrame(frames[i], parser.getFrameNumber(first_frame + i));
+		}
+	}
+
+	if (malformed_lines != 0) {
+		cout << "Skipped " << malformed_lines << " malformed lines.\n";
+	}
+	return true;
+}
+
+void TextFrameParser::findFrames() {
+	const char* data = file.getData();
+	size_t size = file.getSize();
+
+	// every thread collects the headers starting in its part of the file, a header starts after a line break
+	vector<vector<long long>> thread_offsets(thread_count);
+	auto find = [&](int part) {
+		size_t begin = size * part / thread_count;
+		size_t end = size * (part + 1) / thread_count;
+		if (begin == 0 && end != 0 && data[0] == 'F') {
+			thread_offsets[part].push_back(0);
+		}
+		const char* position = data + begin;
+		const char* line_break;
+		while (position < data + end && (line_break = static_cast<const char*>(memchr(position, '\n', data + end - position))) != nullptr) {
+			if (line_break + 1 < data + size && line_break[1] == 'F') {
+				thread_offsets[part].push_back(line_break + 1 - data);
+			}
+			position = line_break + 1;
+		}
+	};
+
+	vector<std::thread> threads;
+	for (int i = 1; i < thread_count; i++) {
+		threads.emplace_back(find, i);
+	}
+	find(0);
+	for (std::thread& each_thread : threads) {
+		each_thread.join();
+	}
+
+	frame_offsets.clear();
+	for (vector<long long>& each_part : thread_offsets) {
+		frame_offsets.insert(frame_offsets.end(), each_part.begin(), each_part.end());
+	}
+}
+
+bool TextFrameParser::parseLine(const char* line, const char* line_end, vector<SphParticle>& particles) const {
+	if (line_end != line && line_end[-1] == '\r') {
+		line_end--;
+	}
+	if (line_end == line) {
+		return true;
+	}
+
+	// x#y#z#vx#vy#vz#mass with an optional #id
+	double values[7];
+	const char* position = line;
+	for (int i = 0; i < 7; i++) {
+		std::from_chars_result result = std::from_chars(position, line_end, values[i]);
+		if (result.ec != std::errc()) {
+			return false;
+		}
+		position = result.ptr;
+		if (i < 6) {
+			if (position == line_end || *position != '#') {
+				return false;
+			}
+			position++;
+		}
+	}
+	unsigned long long id = 0;
+	if (position != line_end) {
+		if (*position != '#') {
+			return false;
+		}
+		std::from_chars_result result = std::from_chars(position + 1, line_end, id);
+		if (result.ec != std::errc() || result.ptr != line_end) {
+			return false;
+		}
+	}
+
+	particles.emplace_back(SphParticle(Vector3(values[0], values[1], values[2]), Vector3(values[3], values[4], values[5]), values[6]));
+	particles.back().id = id;
+	return true;
+}
+
+bool TextFrameParser::hasIds(string textFileName) {
+	ifstream file(textFileName);
+	string line;
+	while (getline(file, line)) {
+		if (!line.empty() && line.front() != 'F' && line != "\r") {
+			return std::count(line.begin(), line.end(), '#') == PARTICLE_RECORD_SIZE_WITH_ID - 1;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <iostream>
+#include <functional>
+
+#include "SphParticle.h"
+#include "MappedFile.h"
+#include "BinaryFrameWriter.h"
+#include "CompressedFrameWriter.h"
+
+using namespace std;
+// Parses text particle files in the format of ParticleIO::exportParticles on a memory mapping.
+// Frames are found at their "F#" header lines and parsed with std::from_chars, several frames at once on worker threads
+class TextFrameParser {
+public:
+	TextFrameParser();
+	~TextFrameParser();
+
+	// finds the frame headers, thread_count 0 uses one thread per core
+	bool open(string fileName, int thread_count = 0);
+	// takes the byte offsets of the frame headers, fails if one of them doesn't point at a header
+	bool open(string fileName, const vector<long long>& frame_offsets, int thread_count = 0);
+	void close();
+	bool isOpen() const;
+
+	size_t getFrameCount() const;
+	const vector<long long>& getFrameOffsets() const;
+	// number from the frame header, position in the file + 1 if the header has none
+	long long getFrameNumber(size_t frame) const;
+	// replaces the contents of particles, returns the number of malformed lines
+	long long parseFrame(size_t frame, vector<SphParticle>& particles) const;
+	// parses frames.size() frames starting at first_frame in parallel
+	long long parseFrames(size_t first_frame, vector<vector<SphParticle>>& frames) const;
+
+	// the binary frames get ids if the particle lines of the text have them
+	static bool convertToBinary(string textFileName, string binaryFileName, int thread_count = 0);
+	static bool convertToCompressed(string textFileName, string compressedFileName, double tolerance = FRAME_CODEC_TOLERANCE, int thread_count = 0);
+
+private:
+	MappedFile file;
+	vector<long long> frame_offsets;
+	int thread_count;
+
+	// parses the frames of the text file in batches and hands them to appendFrame in order
+	static bool convert(string textFileName, function<void(vector<SphParticle>&, long long)> appendFrame, int thread_count);
+	void findFrames();
+	bool parseLine(const char* line, const char* line_end, vector<SphParticle>& particles) const;
+	// looks at the first particle line
+	static bool hasIds(string textFileName);
+};
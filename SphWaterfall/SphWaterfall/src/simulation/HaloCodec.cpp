@@ -0,0 +1,204 @@
+#include "HaloCodec.h"
+
+HaloCodec::HaloCodec() :
+	exchange_count(0),
+	raw_bytes(0),
+	encoded_bytes(0)
+{
+}
+
+HaloCodec::~HaloCodec() {
+
+}
+
+void HaloCodec::beginExchange() {
+	if (exchange_count % HALO_CODEC_REFRESH_INTERVAL == 0) {
+		target_states.clear();
+	}
+	exchange_count++;
+}
+
+void HaloCodec::encode(int target, const std::vector<SphParticle*>& particles, std::vector<char>& buffer) {
+	std::unordered_map<unsigned long long, TransmittedState>& last_states = target_states[target];
+	std::unordered_map<unsigned long long, TransmittedState> states;
+	unsigned long long last_id = 0;
+	size_t start_size = buffer.size();
+
+	for (SphParticle* each_particle : particles) {
+		TransmittedState state = { each_particle->position, each_particle->velocity, each_particle->mass, each_particle->local_density };
+		long long deltas[7];
+		bool is_delta = false;
+
+		auto last_state = last_states.find(each_particle->id);
+		if (each_particle->id != 0 && last_state != last_states.end()) {
+			const TransmittedState& last = last_state->second;
+			is_delta = quantise(state.position.x, last.position.x, HALO_CODEC_POSITION_QUANTUM, deltas[0])
+				&& quantise(state.position.y, last.position.y, HALO_CODEC_POSITION_QUANTUM, deltas[1])
+				&& quantise(state.position.z, last.position.z, HALO_CODEC_POSITION_QUANTUM, deltas[2])
+				&& quantise(state.velocity.x, last.velocity.x, HALO_CODEC_VELOCITY_QUANTUM, deltas[3])
+				&& quantise(state.velocity.y, last.velocity.y, HALO_CODEC_VELOCITY_QUANTUM, deltas[4])
+				&& quantise(state.velocity.z, last.velocity.z, HALO_CODEC_VELOCITY_QUANTUM, deltas[5])
+				&& quantise(state.local_density, last.local_density, HALO_CODEC_DENSITY_QUANTUM, deltas[6]);
+		}
+
+		// zigzag encoded id difference to the previous particle, lowest bit marks an exact particle
+		long long id_delta = static_cast<long long>(each_particle->id - last_id);
+		unsigned long long zigzag_id = (static_cast<unsigned long long>(id_delta) << 1) ^ static_cast<unsigned long long>(id_delta >> 63);
+		writeVarint((zigzag_id << 1) | (is_delta ? 0 : 1), buffer);
+		last_id = each_particle->id;
+
+		if (is_delta) {
+			// the sender continues from what the receiver reconstructs, so the error doesn't accumulate
+			const TransmittedState& last = last_state->second;
+			state.position = Vector3(last.position.x + deltas[0] * HALO_CODEC_POSITION_QUANTUM, last.position.y + deltas[1] * HALO_CODEC_POSITION_QUANTUM,
+				last.position.z + deltas[2] * HALO_CODEC_POSITION_QUANTUM);
+			state.velocity = Vector3(last.velocity.x + deltas[3] * HALO_CODEC_VELOCITY_QUANTUM, last.velocity.y + deltas[4] * HALO_CODEC_VELOCITY_QUANTUM,
+				last.velocity.z + deltas[5] * HALO_CODEC_VELOCITY_QUANTUM);
+			state.mass = last.mass;
+			state.local_density = last.local_density + deltas[6] * HALO_CODEC_DENSITY_QUANTUM;
+			for (int i = 0; i < 7; i++) {
+				writeVarint((static_cast<unsigned long long>(deltas[i]) << 1) ^ static_cast<unsigned long long>(deltas[i] >> 63), buffer);
+			}
+		}
+		else {
+			writeDouble(state.position.x, buffer);
+			writeDouble(state.position.y, buffer);
+			writeDouble(state.position.z, buffer);
+			writeDouble(state.velocity.x, buffer);
+			writeDouble(state.velocity.y, buffer);
+			writeDouble(state.velocity.z, buffer);
+			writeDouble(state.mass, buffer);
+			writeDouble(state.local_density, buffer);
+		}
+
+		if (each_particle->id != 0) {
+			states[each_particle->id] = state;
+		}
+	}
+
+	// particles that left the rim are dropped
+	last_states.swap(states);
+	raw_bytes += static_cast<long long>(particles.size() * sizeof(SphParticle));
+	encoded_bytes += static_cast<long long>(buffer.size() - start_size);
+}
+
+void HaloCodec::decode(int source, const std::vector<char>& buffer, std::vector<SphParticle>& particles, SphParticle::ParticleType particle_type) {
+	std::unordered_map<unsigned long long, TransmittedState>& last_states = source_states[source];
+	std::unordered_map<unsigned long long, TransmittedState> states;
+	unsigned long long last_id = 0;
+	size_t offset = 0;
+
+	while (offset < buffer.size()) {
+		unsigned long long header = readVarint(buffer, offset);
+		unsigned long long zigzag_id = header >> 1;
+		long long id_delta = static_cast<long long>(zigzag_id >> 1) ^ -static_cast<long long>(zigzag_id & 1);
+		unsigned long long id = last_id + static_cast<unsigned long long>(id_delta);
+		last_id = id;
+
+		TransmittedState state;
+		if ((header & 1) == 0) {
+			const TransmittedState& last = last_states.at(id);
+			long long deltas[7];
+			for (int i = 0; i < 7; i++) {
+				unsigned long long zigzag_delta = readVarint(buffer, offset);
+				deltas[i] = static_cast<long long>(zigzag_delta >> 1) ^ -static_cast<long long>(zigzag_delta & 1);
+			}
+			state.position = Vector3(last.position.x + deltas[0] * HALO_CODEC_POSITION_QUANTUM, last.position.y + deltas[1] * HALO_CODEC_POSITION_QUANTUM,
+				last.position.z + deltas[2] * HALO_CODEC_POSITION_QUANTUM);
+			state.velocity = Vector3(last.velocity.x + deltas[3] * HALO_CODEC_VELOCITY_QUANTUM, last.velocity.y + deltas[4] * HALO_CODEC_VELOCITY_QUANTUM,
+				last.velocity.z + deltas[5] * HALO_CODEC_VELOCITY_QUANTUM);
+			state.mass = last.mass;
+			state.local_density = last.local_density + deltas[6] * HALO_CODEC_DENSITY_QUANTUM;
+		}
+		else {
+			state.position.x = readDouble(buffer, offset);
+			state.position.y = readDouble(buffer, offset);
+			state.position.z = readDouble(buffer, offset);
+			state.velocity.x = readDouble(buffer, offset);
+			state.velocity.y = readDouble(buffer, offset);
+			state.velocity.z = readDouble(buffer, offset);
+			state.mass = readDouble(buffer, offset);
+			state.local_density = readDouble(buffer, offset);
+		}
+
+		SphParticle particle(state.position, particle_type);
+		particle.velocity = state.velocity;
+		particle.mass = state.mass;
+		particle.local_density = state.local_density;
+		particle.id = id;
+		particles.push_back(particle);
+
+		if (id != 0) {
+			states[id] = state;
+		}
+	}
+
+	last_states.swap(states);
+}
+
+void HaloCodec::forgetTarget(int target) {
+	target_states.erase(target);
+}
+
+void HaloCodec::forgetSource(int source) {
+	source_states.erase(source);
+}
+
+void HaloCodec::reset() {
+	exchange_count = 0;
+	raw_bytes = 0;
+	encoded_bytes = 0;
+	target_states.clear();
+	source_states.clear();
+}
+
+long long HaloCodec::getRawBytes() const {
+	return raw_bytes;
+}
+
+long long HaloCodec::getEncodedBytes() const {
+	return encoded_bytes;
+}
+
+bool HaloCodec::quantise(double value, double last_value, double quantum, long long& delta) {
+	double steps = std::round((value - last_value) / quantum);
+	// large jumps are cheaper to send exactly
+	if (!(std::abs(steps) < 1e15)) {
+		return false;
+	}
+	delta = static_cast<long long>(steps);
+	return true;
+}
+
+void HaloCodec::writeVarint(unsigned long long value, std::vector<char>& buffer) {
+	while (value >= 0x80) {
+		buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back(static_cast<char>(value));
+}
+
+unsigned long long HaloCodec::readVarint(const std::vector<char>& buffer, size_t& offset) {
+	unsigned long long value = 0;
+	int shift = 0;
+	unsigned char byte;
+	do {
+		byte = static_cast<unsigned char>(buffer[offset++]);
+		value |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+		shift += 7;
+	} while ((byte & 0x80) != 0);
+	return value;
+}
+
+void HaloCodec::writeDouble(double value, std::vector<char>& buffer) {
+	char bytes[sizeof(double)];
+	std::memcpy(bytes, &value, sizeof(double));
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(double));
+}
+
+double HaloCodec::readDouble(const std::vector<char>& buffer, size_t& offset) {
+	double value;
+	std::memcpy(&value, buffer.data() + offset, sizeof(double));
+	offset += sizeof(double);
+	return value;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "SimulationUtilities.h"
+#include "../data/SphParticle.h"
+
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
+
+// Rim particle encoding as particle ids plus quantised deltas against the values the receiver got last time.
+// Particles that are new to a receiver, and all particles every HALO_CODEC_REFRESH_INTERVAL exchanges, are sent exactly.
+// The codec is lossy: in between, a received position, velocity or density is off by at most half its quantum, which doesn't
+// accumulate because the sender continues from the reconstructed values. The forces see that error, so the exported frames
+// can drift slightly (around 1e-5) from a run without the codec
+class HaloCodec {
+public:
+	HaloCodec();
+	~HaloCodec();
+
+	// once per rim exchange on every process, before anything is encoded
+	void beginExchange();
+	void encode(int target, const std::vector<SphParticle*>& particles, std::vector<char>& buffer);
+	void decode(int source, const std::vector<char>& buffer, std::vector<SphParticle>& particles, SphParticle::ParticleType particle_type);
+	// the particles of this pair didn't go through the codec, so both sides forget what was transmitted
+	void forgetTarget(int target);
+	void forgetSource(int source);
+	void reset();
+
+	long long getRawBytes() const;
+	long long getEncodedBytes() const;
+
+private:
+	// the values as the receiver reconstructed them
+	struct TransmittedState {
+		Vector3 position;
+		Vector3 velocity;
+		double mass;
+		double local_density;
+	};
+
+	int exchange_count;
+	long long raw_bytes;
+	long long encoded_bytes;
+	std::unordered_map<int, std::unordered_map<unsigned long long, TransmittedState>> target_states;
+	std::unordered_map<int, std::unordered_map<unsigned long long, TransmittedState>> source_states;
+
+	static bool quantise(double value, double last_value, double quantum, long long& delta);
+	static void writeVarint(unsigned long long value, std::vector<char>& buffer);
+	static unsigned long long readVarint(const std::vector<char>& buffer, size_t& offset);
+	static void writeDouble(double value, std::vector<char>& buffer);
+	static double readDouble(const std::vector<char>& buffer, size_t& offset);
+};
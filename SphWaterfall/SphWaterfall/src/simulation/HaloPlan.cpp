@@ -0,0 +1,153 @@
+#include "HaloPlan.h"
+
+using namespace SimulationUtilities;
+
+HaloPlan::HaloPlan() :
+	is_built(false)
+{
+}
+
+HaloPlan::~HaloPlan() {
+
+}
+
+bool HaloPlan::prepare(std::unordered_map<int, std::vector<int>>& outgoing_meta, std::unordered_map<int, long long>& outgoing_counts) {
+	// invalid, too large
+	int flags[2] = { is_built ? 0 : 1, 0 };
+	for (auto& each_target : outgoing_meta) {
+		if (each_target.second.empty()) {
+			continue;
+		}
+		long long count = outgoing_counts[each_target.first];
+		if (count > MAX_PARTICLES_PER_MESSAGE) {
+			flags[1] = 1;
+		}
+		else if (target_meta_capacities.count(each_target.first) == 0 || each_target.second.size() > target_meta_capacities.at(each_target.first)
+			|| count > target_particle_capacities.at(each_target.first)) {
+			flags[0] = 1;
+		}
+	}
+	int any_flags[2];
+	MPI_Allreduce(flags, any_flags, 2, MPI_INT, MPI_LOR, slave_comm);
+
+	if (any_flags[1] != 0) {
+		release();
+		return false;
+	}
+	if (any_flags[0] != 0) {
+		build(outgoing_meta, outgoing_counts);
+	}
+	return true;
+}
+
+void HaloPlan::start(std::unordered_map<int, std::vector<int>>& outgoing_meta) {
+	for (int target : targets) {
+		std::vector<int>& meta = outgoing_meta[target];
+		std::vector<int>& send_buffer = meta_send_buffers[target];
+		send_buffer[0] = static_cast<int>(meta.size());
+		std::copy(meta.begin(), meta.end(), send_buffer.begin() + 1);
+	}
+	// an empty request list may have no data pointer, which MPI_Startall rejects
+	if (!requests.empty()) {
+		MPI_Startall(static_cast<int>(requests.size()), requests.data());
+	}
+}
+
+void HaloPlan::finish(std::unordered_map<int, std::vector<int>>& incoming_meta, std::unordered_map<int, std::vector<SphParticle>>& incoming_particles) {
+	MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+
+	for (int source : sources) {
+		std::vector<int>& receive_buffer = meta_receive_buffers[source];
+		incoming_meta[source] = std::vector<int>(receive_buffer.begin() + 1, receive_buffer.begin() + 1 + receive_buffer[0]);
+		int total_count = 0;
+		for (int i = 2; i < incoming_meta[source].size(); i += 3) {
+			total_count += incoming_meta[source][i];
+		}
+		// shrinking keeps the storage, so the receive request stays bound to it
+		particle_buffers[source].resize(total_count);
+		incoming_particles[source].swap(particle_buffers[source]);
+	}
+}
+
+void HaloPlan::reclaim(std::unordered_map<int, std::vector<SphParticle>>& incoming_particles) {
+	for (int source : sources) {
+		if (incoming_particles.count(source) != 0 && particle_buffers[source].empty()) {
+			particle_buffers[source].swap(incoming_particles[source]);
+			particle_buffers[source].resize(source_particle_capacities[source]);
+			incoming_particles.erase(source);
+		}
+	}
+}
+
+const std::vector<int>& HaloPlan::getTargets() const {
+	return targets;
+}
+
+void HaloPlan::release() {
+	if (!is_built) {
+		return;
+	}
+	freeRequests();
+	is_built = false;
+}
+
+void HaloPlan::build(std::unordered_map<int, std::vector<int>>& outgoing_meta, std::unordered_map<int, long long>& outgoing_counts) {
+	freeRequests();
+
+	// meta count, particle count for every process
+	std::vector<int> outgoing_sizes(2 * slave_comm_size, 0);
+	std::vector<int> incoming_sizes(2 * slave_comm_size, 0);
+	for (auto& each_target : outgoing_meta) {
+		if (!each_target.second.empty()) {
+			outgoing_sizes[2 * each_target.first] = static_cast<int>(each_target.second.size());
+			outgoing_sizes[2 * each_target.first + 1] = static_cast<int>(outgoing_counts[each_target.first]);
+		}
+	}
+	MPI_Alltoall(outgoing_sizes.data(), 2, MPI_INT, incoming_sizes.data(), 2, MPI_INT, slave_comm);
+
+	// sender and receiver derive the same capacities from the same sizes
+	for (int i = 0; i < slave_comm_size; i++) {
+		if (outgoing_sizes[2 * i] != 0) {
+			targets.push_back(i);
+			target_meta_capacities[i] = computeCapacity(outgoing_sizes[2 * i]);
+			target_particle_capacities[i] = computeCapacity(outgoing_sizes[2 * i + 1]);
+			meta_send_buffers[i] = std::vector<int>(target_meta_capacities[i] + 1);
+
+			requests.push_back(MPI_REQUEST_NULL);
+			MPI_Send_init(meta_send_buffers[i].data(), target_meta_capacities[i] + 1, MPI_INT, i, META_RIM_TAG, slave_comm, &requests.back());
+		}
+		if (incoming_sizes[2 * i] != 0) {
+			sources.push_back(i);
+			int meta_capacity = computeCapacity(incoming_sizes[2 * i]);
+			source_particle_capacities[i] = computeCapacity(incoming_sizes[2 * i + 1]);
+			meta_receive_buffers[i] = std::vector<int>(meta_capacity + 1);
+			particle_buffers[i] = std::vector<SphParticle>(source_particle_capacities[i]);
+
+			requests.push_back(MPI_REQUEST_NULL);
+			MPI_Recv_init(meta_receive_buffers[i].data(), meta_capacity + 1, MPI_INT, i, META_RIM_TAG, slave_comm, &requests.back());
+			requests.push_back(MPI_REQUEST_NULL);
+			MPI_Recv_init(particle_buffers[i].data(), source_particle_capacities[i], getParticleDatatype(), i, RIM_TAG, slave_comm, &requests.back());
+		}
+	}
+	is_built = true;
+}
+
+void HaloPlan::freeRequests() {
+	for (auto& each_request : requests) {
+		MPI_Request_free(&each_request);
+	}
+	requests.clear();
+	targets.clear();
+	sources.clear();
+	target_meta_capacities.clear();
+	target_particle_capacities.clear();
+	source_particle_capacities.clear();
+	meta_send_buffers.clear();
+	meta_receive_buffers.clear();
+	particle_buffers.clear();
+}
+
+int HaloPlan::computeCapacity(int needed) {
+	// room for the rim to grow before the plan has to be rebuilt
+	return std::min(needed + needed / 2 + 16, MAX_PARTICLES_PER_MESSAGE);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "mpi.h"
+#include "SimulationUtilities.h"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+// Persistent rim exchange: neighbours, message capacities, receive buffers and requests are kept across timesteps
+// and only rebuilt when a message doesn't fit into the plan anymore
+class HaloPlan {
+public:
+	HaloPlan();
+	~HaloPlan();
+
+	// collective, rebuilds the plan if it is invalid for any process, returns false if a message is too large for a single request
+	bool prepare(std::unordered_map<int, std::vector<int>>& outgoing_meta, std::unordered_map<int, long long>& outgoing_counts);
+	// starts the persistent meta sends and all receives
+	void start(std::unordered_map<int, std::vector<int>>& outgoing_meta);
+	// waits for the receives, the particle buffers are handed over to incoming_particles
+	void finish(std::unordered_map<int, std::vector<int>>& incoming_meta, std::unordered_map<int, std::vector<SphParticle>>& incoming_particles);
+	// takes the particle buffers back before the next exchange, they are bound to the receive requests
+	void reclaim(std::unordered_map<int, std::vector<SphParticle>>& incoming_particles);
+	// processes that expect rim particles from this process, even if there are none in this timestep
+	const std::vector<int>& getTargets() const;
+	void release();
+
+private:
+	bool is_built;
+	std::vector<int> targets;
+	std::vector<int> sources;
+	std::unordered_map<int, int> target_meta_capacities;
+	std::unordered_map<int, int> target_particle_capacities;
+	std::unordered_map<int, int> source_particle_capacities;
+
+	// the first entry is the meta count
+	std::unordered_map<int, std::vector<int>> meta_send_buffers;
+	std::unordered_map<int, std::vector<int>> meta_receive_buffers;
+	std::unordered_map<int, std::vector<SphParticle>> particle_buffers;
+	std::vector<MPI_Request> requests;
+
+	void build(std::unordered_map<int, std::vector<int>>& outgoing_meta, std::unordered_map<int, long long>& outgoing_counts);
+	void freeRequests();
+	int computeCapacity(int needed);
+};
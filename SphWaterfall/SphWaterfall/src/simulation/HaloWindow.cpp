@@ -0,0 +1,147 @@
+#include "HaloWindow.h"
+
+using namespace SimulationUtilities;
+
+HaloWindow::HaloWindow() :
+	is_allocated(false),
+	meta_capacity(0),
+	particle_capacity(0)
+{
+}
+
+HaloWindow::~HaloWindow() {
+
+}
+
+void HaloWindow::exchange(std::unordered_map<int, std::vector<int>>& outgoing_meta, std::unordered_map<int, std::vector<SphParticle>>& outgoing_particles,
+	std::unordered_map<int, std::vector<int>>& incoming_meta, std::unordered_map<int, std::vector<SphParticle>>& incoming_particles) {
+	if (!is_allocated) {
+		MPI_Comm_rank(slave_comm, &mpi_rank);
+		MPI_Win_allocate(4 * slave_comm_size * sizeof(int), sizeof(int), MPI_INFO_NULL, slave_comm, &control_buffer, &control_window);
+		allocateDataWindows(0, 0);
+		is_allocated = true;
+	}
+
+	// put counts into the control slot of this process at every target
+	std::vector<int> outgoing_counts(2 * slave_comm_size, 0);
+	std::fill(control_buffer, control_buffer + 4 * slave_comm_size, 0);
+	MPI_Win_fence(0, control_window);
+	for (int i = 0; i < slave_comm_size; i++) {
+		if (i != mpi_rank) {
+			outgoing_counts[2 * i] = static_cast<int>(outgoing_meta[i].size());
+			outgoing_counts[2 * i + 1] = static_cast<int>(outgoing_particles[i].size());
+			if (outgoing_counts[2 * i] != 0) {
+				MPI_Put(&outgoing_counts[2 * i], 2, MPI_INT, i, 2 * mpi_rank, 2, MPI_INT, control_window);
+			}
+		}
+	}
+	MPI_Win_fence(0, control_window);
+
+	// compute where each source writes to and publish the offsets
+	int meta_needed = 0;
+	int particle_needed = 0;
+	source_ranges.clear();
+	for (int i = 0; i < slave_comm_size; i++) {
+		control_buffer[2 * slave_comm_size + 2 * i] = meta_needed;
+		control_buffer[2 * slave_comm_size + 2 * i + 1] = particle_needed;
+		if (control_buffer[2 * i] != 0) {
+			source_ranges[i] = std::make_pair(particle_needed, control_buffer[2 * i + 1]);
+		}
+		meta_needed += control_buffer[2 * i];
+		particle_needed += control_buffer[2 * i + 1];
+	}
+	ensureCapacity(meta_needed, particle_needed);
+
+	// get offsets from every target
+	std::vector<int> outgoing_offsets(2 * slave_comm_size, 0);
+	MPI_Win_fence(0, control_window);
+	for (int i = 0; i < slave_comm_size; i++) {
+		if (i != mpi_rank && outgoing_counts[2 * i] != 0) {
+			MPI_Get(&outgoing_offsets[2 * i], 2, MPI_INT, i, 2 * slave_comm_size + 2 * mpi_rank, 2, MPI_INT, control_window);
+		}
+	}
+	MPI_Win_fence(0, control_window);
+
+	// put meta and particles
+	target_offsets.clear();
+	MPI_Win_fence(MPI_MODE_NOPRECEDE, meta_window);
+	MPI_Win_fence(MPI_MODE_NOPRECEDE, particle_window);
+	for (int i = 0; i < slave_comm_size; i++) {
+		if (i != mpi_rank && outgoing_counts[2 * i] != 0) {
+			target_offsets[i] = outgoing_offsets[2 * i + 1];
+			MPI_Put(outgoing_meta[i].data(), outgoing_counts[2 * i], MPI_INT, i, outgoing_offsets[2 * i], outgoing_counts[2 * i], MPI_INT, meta_window);
+			// typed counts in chunks, a byte count overflows long before the particle count does
+			for (int offset = 0; offset < outgoing_counts[2 * i + 1]; offset += MAX_PARTICLES_PER_MESSAGE) {
+				int count = std::min(outgoing_counts[2 * i + 1] - offset, MAX_PARTICLES_PER_MESSAGE);
+				MPI_Put(outgoing_particles[i].data() + offset, count, getParticleDatatype(), i, outgoing_offsets[2 * i + 1] + offset, count, getParticleDatatype(), particle_window);
+			}
+		}
+	}
+	MPI_Win_fence(MPI_MODE_NOSUCCEED, meta_window);
+	MPI_Win_fence(MPI_MODE_NOSUCCEED, particle_window);
+
+	// copy out of the windows, they are overwritten by the next exchange
+	for (int i = 0; i < slave_comm_size; i++) {
+		int meta_count = control_buffer[2 * i];
+		if (meta_count != 0) {
+			int meta_offset = control_buffer[2 * slave_comm_size + 2 * i];
+			int particle_offset = control_buffer[2 * slave_comm_size + 2 * i + 1];
+			incoming_meta[i] = std::vector<int>(meta_buffer + meta_offset, meta_buffer + meta_offset + meta_count);
+			incoming_particles[i] = std::vector<SphParticle>(particle_buffer + particle_offset, particle_buffer + particle_offset + control_buffer[2 * i + 1]);
+		}
+	}
+}
+
+void HaloWindow::exchangeDensities(std::unordered_map<int, std::vector<double>>& outgoing_densities, std::unordered_map<int, std::vector<double>>& incoming_densities) {
+	MPI_Win_fence(MPI_MODE_NOPRECEDE, density_window);
+	for (auto& each_target : target_offsets) {
+		std::vector<double>& densities = outgoing_densities[each_target.first];
+		if (!densities.empty()) {
+			MPI_Put(densities.data(), static_cast<int>(densities.size()), MPI_DOUBLE, each_target.first, each_target.second,
+				static_cast<int>(densities.size()), MPI_DOUBLE, density_window);
+		}
+	}
+	MPI_Win_fence(MPI_MODE_NOSUCCEED, density_window);
+
+	for (auto& each_source : source_ranges) {
+		int offset = each_source.second.first;
+		incoming_densities[each_source.first] = std::vector<double>(density_buffer + offset, density_buffer + offset + each_source.second.second);
+	}
+}
+
+void HaloWindow::release() {
+	if (!is_allocated) {
+		return;
+	}
+	freeDataWindows();
+	MPI_Win_free(&control_window);
+	target_offsets.clear();
+	source_ranges.clear();
+	is_allocated = false;
+}
+
+void HaloWindow::allocateDataWindows(int meta_capacity, int particle_capacity) {
+	this->meta_capacity = meta_capacity;
+	this->particle_capacity = particle_capacity;
+	MPI_Win_allocate(meta_capacity * sizeof(int), sizeof(int), MPI_INFO_NULL, slave_comm, &meta_buffer, &meta_window);
+	MPI_Win_allocate(particle_capacity * sizeof(SphParticle), sizeof(SphParticle), MPI_INFO_NULL, slave_comm, &particle_buffer, &particle_window);
+	MPI_Win_allocate(particle_capacity * sizeof(double), sizeof(double), MPI_INFO_NULL, slave_comm, &density_buffer, &density_window);
+}
+
+void HaloWindow::freeDataWindows() {
+	MPI_Win_free(&meta_window);
+	MPI_Win_free(&particle_window);
+	MPI_Win_free(&density_window);
+}
+
+void HaloWindow::ensureCapacity(int meta_needed, int particle_needed) {
+	// window allocation is collective, so every process reallocates as soon as one of them is too small
+	int needs_growth = (meta_needed > meta_capacity || particle_needed > particle_capacity) ? 1 : 0;
+	int any_needs_growth;
+	MPI_Allreduce(&needs_growth, &any_needs_growth, 1, MPI_INT, MPI_LOR, slave_comm);
+
+	if (any_needs_growth != 0) {
+		freeDataWindows();
+		allocateDataWindows(std::max(meta_capacity, meta_needed + meta_needed / 2), std::max(particle_capacity, particle_needed + particle_needed / 2));
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "mpi.h"
+#include "SimulationUtilities.h"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+// One-sided rim exchange: every process exposes its receive buffers as MPI windows and the neighbours put their rim particles into them
+class HaloWindow {
+public:
+	HaloWindow();
+	~HaloWindow();
+
+	// target process id -> meta / rim particles, source process id -> meta / rim particles
+	void exchange(std::unordered_map<int, std::vector<int>>& outgoing_meta, std::unordered_map<int, std::vector<SphParticle>>& outgoing_particles,
+		std::unordered_map<int, std::vector<int>>& incoming_meta, std::unordered_map<int, std::vector<SphParticle>>& incoming_particles);
+	// densities of the particles moved by the last exchange, in the same order
+	void exchangeDensities(std::unordered_map<int, std::vector<double>>& outgoing_densities, std::unordered_map<int, std::vector<double>>& incoming_densities);
+	// collective, frees all windows
+	void release();
+
+private:
+	bool is_allocated;
+	int mpi_rank;
+	int meta_capacity;
+	int particle_capacity;
+
+	// per source: meta count, particle count, meta offset, particle offset
+	MPI_Win control_window;
+	int* control_buffer;
+
+	MPI_Win meta_window;
+	int* meta_buffer;
+	MPI_Win particle_window;
+	SphParticle* particle_buffer;
+	MPI_Win density_window;
+	double* density_buffer;
+
+	// particle offset of this process inside the buffer of each target of the last exchange
+	std::unordered_map<int, int> target_offsets;
+	// particle offset and count of each source of the last exchange
+	std::unordered_map<int, std::pair<int, int>> source_ranges;
+
+	void allocateDataWindows(int meta_capacity, int particle_capacity);
+	void freeDataWindows();
+	void ensureCapacity(int meta_needed, int particle_needed);
+};
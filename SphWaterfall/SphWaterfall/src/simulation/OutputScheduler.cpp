@@ -0,0 +1,95 @@
+#include "OutputScheduler.h"
+
+OutputScheduler::OutputScheduler() {
+	for (auto& each_stream : streams) {
+		each_stream.interval = 1;
+		each_stream.has_region = false;
+		each_stream.fields = ALL_FIELDS;
+		each_stream.content = ALL_PARTICLES;
+	}
+	streams[STATISTICS_STREAM].interval = 0;
+	streams[CHECKPOINT_STREAM].interval = 0;
+}
+
+OutputScheduler::~OutputScheduler() {
+
+}
+
+void OutputScheduler::setInterval(Stream stream, int interval) {
+	streams[stream].interval = interval;
+}
+
+void OutputScheduler::setRegion(Stream stream, const Vector3& region_min, const Vector3& region_max) {
+	streams[stream].has_region = true;
+	streams[stream].region_min = Vector3(std::min(region_min.x, region_max.x), std::min(region_min.y, region_max.y), std::min(region_min.z, region_max.z));
+	streams[stream].region_max = Vector3(std::max(region_min.x, region_max.x), std::max(region_min.y, region_max.y), std::max(region_min.z, region_max.z));
+}
+
+void OutputScheduler::clearRegion(Stream stream) {
+	streams[stream].has_region = false;
+}
+
+void OutputScheduler::setFields(Stream stream, int fields) {
+	streams[stream].fields = fields;
+}
+
+void OutputScheduler::setContent(Stream stream, Content content) {
+	streams[stream].content = content;
+}
+
+bool OutputScheduler::isDue(Stream stream, int timestep) const {
+	return streams[stream].interval > 0 && timestep % streams[stream].interval == 0;
+}
+
+bool OutputScheduler::isExportDue(int timestep) const {
+	return isDue(VTK_STREAM, timestep) || isDue(FRAME_STREAM, timestep);
+}
+
+bool OutputScheduler::isSurfaceDue(int timestep) const {
+	return (isDue(VTK_STREAM, timestep) && streams[VTK_STREAM].content == SURFACE_PARTICLES)
+		|| (isDue(FRAME_STREAM, timestep) && streams[FRAME_STREAM].content == SURFACE_PARTICLES);
+}
+
+bool OutputScheduler::isInContent(Stream stream, bool is_surface, bool is_interior_cell) const {
+	if (streams[stream].content == SURFACE_PARTICLES) {
+		return is_surface || is_interior_cell;
+	}
+	return !is_interior_cell;
+}
+
+bool OutputScheduler::isInRegion(Stream stream, const Vector3& position) const {
+	const StreamSettings& settings = streams[stream];
+	if (!settings.has_region) {
+		return true;
+	}
+	return position.x >= settings.region_min.x && position.x <= settings.region_max.x
+		&& position.y >= settings.region_min.y && position.y <= settings.region_max.y
+		&& position.z >= settings.region_min.z && position.z <= settings.region_max.z;
+}
+
+bool OutputScheduler::isExported(const Vector3& position, bool is_surface, bool is_interior_cell, int timestep) const {
+	return (isDue(VTK_STREAM, timestep) && isInRegion(VTK_STREAM, position) && isInContent(VTK_STREAM, is_surface, is_interior_cell))
+		|| (isDue(FRAME_STREAM, timestep) && isInRegion(FRAME_STREAM, position) && isInContent(FRAME_STREAM, is_surface, is_interior_cell));
+}
+
+int OutputScheduler::getFields(Stream stream) const {
+	return streams[stream].fields;
+}
+
+OutputScheduler::Content OutputScheduler::getContent(Stream stream) const {
+	return streams[stream].content;
+}
+
+int OutputScheduler::countDue(Stream stream, int number_of_timesteps) const {
+	if (streams[stream].interval <= 0) {
+		return 0;
+	}
+	return number_of_timesteps / streams[stream].interval;
+}
+
+int OutputScheduler::countDue(Stream stream, int first_timestep, int last_timestep) const {
+	if (streams[stream].interval <= 0 || last_timestep < first_timestep) {
+		return 0;
+	}
+	return last_timestep / streams[stream].interval - (first_timestep - 1) / streams[stream].interval;
+}
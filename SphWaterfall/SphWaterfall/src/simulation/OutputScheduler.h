@@ -0,0 +1,74 @@
+#pragma once
+#include "../data/Vector3.h"
+
+#include <array>
+#include <algorithm>
+
+// Decides for every output stream on which timesteps it is written, which region it covers and which fields it contains.
+// Every process holds the same settings, so slaves and master agree on the timesteps with a transfer
+class OutputScheduler {
+public:
+	enum Stream
+	{
+		VTK_STREAM,
+		FRAME_STREAM,
+		STATISTICS_STREAM,
+		// the whole simulation state, region and fields don't apply
+		CHECKPOINT_STREAM,
+		STREAM_COUNT
+	};
+
+	enum Content
+	{
+		ALL_PARTICLES,
+		// particles near the free surface and one particle per cell for the interior
+		SURFACE_PARTICLES
+	};
+
+	enum Field
+	{
+		NORM_FIELD = 1,
+		VELOCITY_FIELD = 2,
+		DENSITY_FIELD = 4,
+		RANK_FIELD = 8,
+		ALL_FIELDS = 15
+	};
+
+	OutputScheduler();
+	~OutputScheduler();
+
+	// every interval timesteps, 0 disables the stream
+	void setInterval(Stream, int interval);
+	void setRegion(Stream, const Vector3& region_min, const Vector3& region_max);
+	void clearRegion(Stream);
+	void setFields(Stream, int fields);
+	void setContent(Stream, Content);
+
+	bool isDue(Stream, int timestep) const;
+	// particles have to be sent to the master or written for vtk or frames
+	bool isExportDue(int timestep) const;
+	bool isInRegion(Stream, const Vector3& position) const;
+	// a surface-only particle stream is due, the fluid has to be classified
+	bool isSurfaceDue(int timestep) const;
+	// interior cells only belong to surface-only streams, the particles they stand for only to the others
+	bool isInContent(Stream, bool is_surface, bool is_interior_cell) const;
+	// inside the region and content of a particle stream that is due
+	bool isExported(const Vector3& position, bool is_surface, bool is_interior_cell, int timestep) const;
+	int getFields(Stream) const;
+	Content getContent(Stream) const;
+	int countDue(Stream, int number_of_timesteps) const;
+	// due timesteps from first_timestep to last_timestep, both included
+	int countDue(Stream, int first_timestep, int last_timestep) const;
+
+private:
+	struct StreamSettings {
+		int interval;
+		bool has_region;
+		Vector3 region_min;
+		Vector3 region_max;
+		int fields;
+		Content content;
+	};
+
+	std::array<StreamSettings, STREAM_COUNT> streams;
+};
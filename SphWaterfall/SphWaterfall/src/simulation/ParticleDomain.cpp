@@ -95,6 +95,14 @@ void ParticleDomain::addNeighbourRimParticles(const std::unordered_map<int, std:
 	}
 }
 
+std::vector<SphParticle*> ParticleDomain::getNeighbourRimParticles(SphParticle::ParticleType particle_type) {
+	std::vector<SphParticle*> result;
+	for (auto& each_neighbour : neighbour_particles[particle_type]) {
+		result.insert(result.end(), each_neighbour.second.begin(), each_neighbour.second.end());
+	}
+	return result;
+}
+
 std::unordered_map<int, std::vector<SphParticle*>> ParticleDomain::getNeighbourRimParticles() {
 	std::unordered_map<int, std::vector<SphParticle*>> result;
 	for (auto& each_neighbour_list : neighbour_particles) {
@@ -107,20 +115,132 @@ std::unordered_map<int, std::vector<SphParticle*>> ParticleDomain::getNeighbourR
 	return result;
 }
 
-std::unordered_map<int, std::vector<SphParticle*>> ParticleDomain::getRimParticleTargetMap(SphParticle::ParticleType particle_type) {
-	std::unordered_map<int, std::vector<SphParticle*>> target_map;
-	int domain_id = SimulationUtilities::computeDomainID(origin, dimensions);
-	for (SphParticle& particle : particles[particle_type]) {
-		for (int x = -1; x <= 1; x++) {
-			for (int y = -1; y <= 1; y++) {
-				for (int z = -1; z <= 1; z++) {
-					int id = SimulationUtilities::computeDomainID(particle.position + ((Vector3(x, y, z).normalize() * Q_MAX)), dimensions);
-					if (id != domain_id) {
-						target_map[id].push_back(&particle);
+int ParticleDomain::computeRimRegion(const Vector3& position, double rim_width) const {
+	// per axis: 0 within rim_width of the lower face, 2 within rim_width of the upper face, 1 otherwise
+	Vector3 lower = position - origin;
+	Vector3 upper = origin + dimensions - position;
+	int x = (lower.x <= rim_width) ? 0 : ((upper.x <= rim_width) ? 2 : 1);
+	int y = (lower.y <= rim_width) ? 0 : ((upper.y <= rim_width) ? 2 : 1);
+	int z = (lower.z <= rim_width) ? 0 : ((upper.z <= rim_width) ? 2 : 1);
+	return x * 9 + y * 3 + z;
+}
+
+bool ParticleDomain::isWithinDistance(const Vector3& position, double distance) const {
+	Vector3 upper_corner = origin + dimensions;
+	double outside_x = std::max(0.0, std::max(origin.x - position.x, position.x - upper_corner.x));
+	double outside_y = std::max(0.0, std::max(origin.y - position.y, position.y - upper_corner.y));
+	double outside_z = std::max(0.0, std::max(origin.z - position.z, position.z - upper_corner.z));
+	return (outside_x * outside_x + outside_y * outside_y + outside_z * outside_z) <= (distance * distance);
+}
+
+void ParticleDomain::partitionRimRegions(SphParticle::ParticleType particle_type, double rim_width) {
+	std::vector<SphParticle>& type_particles = particles[particle_type];
+	std::array<int, 28>& offsets = region_offsets[particle_type];
+
+	std::array<int, 27> region_counts = {};
+	for (SphParticle& each_particle : type_particles) {
+		region_counts[computeRimRegion(each_particle.position, rim_width)]++;
+	}
+	offsets[0] = 0;
+	for (int i = 0; i < 27; i++) {
+		offsets[i + 1] = offsets[i] + region_counts[i];
+	}
+
+	// in place, particles that are already inside the range of their region stay where they are. Only those that crossed
+	// a region border, or sit where a border moved because particles were added or removed, are swapped into their range
+	std::array<int, 27> next_index;
+	std::copy(offsets.begin(), offsets.end() - 1, next_index.begin());
+	for (int region = 0; region < 27; region++) {
+		while (next_index[region] < offsets[region + 1]) {
+			int target = computeRimRegion(type_particles[next_index[region]].position, rim_width);
+			if (target == region) {
+				next_index[region]++;
+				continue;
+			}
+			while (computeRimRegion(type_particles[next_index[target]].position, rim_width) == target) {
+				next_index[target]++;
+			}
+			std::swap(type_particles[next_index[region]], type_particles[next_index[target]]);
+			next_index[target]++;
+		}
+	}
+}
+
+std::unordered_map<int, std::vector<SphParticle*>> ParticleDomain::getRimParticleTargetMap(SphParticle::ParticleType particle_type, double rim_width) {
+	partitionRimRegions(particle_type, rim_width);
+	std::vector<SphParticle>& type_particles = particles[particle_type];
+	std::array<int, 28>& offsets = region_offsets[particle_type];
+
+	// the 27 domains around this one, index (x + 1) * 9 + (y + 1) * 3 + (z + 1)
+	std::array<int, 27> neighbour_domain_ids;
+	std::array<std::vector<SphParticle*>, 27> rim_particles;
+	Vector3 center = origin + (0.5 * dimensions);
+	for (int x = -1; x <= 1; x++) {
+		for (int y = -1; y <= 1; y++) {
+			for (int z = -1; z <= 1; z++) {
+				neighbour_domain_ids[(x + 1) * 9 + (y + 1) * 3 + (z + 1)] = SimulationUtilities::computeDomainID(center + (Vector3(x, y, z) * dimensions), dimensions);
+			}
+		}
+	}
+
+	// a domain thinner than two rims puts every particle into the lower or upper region of that axis, so these axes
+	// match any region and are checked per particle
+	bool is_thin[3] = { dimensions.x < 2.0 * rim_width, dimensions.y < 2.0 * rim_width, dimensions.z < 2.0 * rim_width };
+
+	// regions in ascending order, so the rim particles of each target stay in runs of consecutive particles
+	double rim_width_squared = rim_width * rim_width;
+	Vector3 upper_corner = origin + dimensions;
+	for (int region = 0; region < 27; region++) {
+		if (region == 13 || offsets[region] == offsets[region + 1]) {
+			continue;
+		}
+		int region_axes[3] = { region / 9, (region / 3) % 3, region % 3 };
+
+		// every combination of the crossed faces is a target, 0 keeps the axis
+		for (int x = 0; x < 3; x++) {
+			for (int y = 0; y < 3; y++) {
+				for (int z = 0; z < 3; z++) {
+					int target_axes[3] = { x, y, z };
+					int crossed_faces = 0;
+					bool is_target = true;
+					bool crosses_thin_axis = false;
+					for (int axis = 0; axis < 3; axis++) {
+						if (target_axes[axis] != 1) {
+							is_target = is_target && (target_axes[axis] == region_axes[axis] || is_thin[axis]);
+							crosses_thin_axis = crosses_thin_axis || is_thin[axis];
+							crossed_faces++;
+						}
+					}
+					if (!is_target || crossed_faces == 0) {
+						continue;
+					}
+
+					std::vector<SphParticle*>& target_particles = rim_particles[x * 9 + y * 3 + z];
+					for (int i = offsets[region]; i < offsets[region + 1]; i++) {
+						SphParticle& particle = type_particles[i];
+						if (crossed_faces > 1 || crosses_thin_axis) {
+							// edge and corner neighbours are only relevant within rim_width of the edge or corner
+							Vector3 lower = particle.position - origin;
+							Vector3 upper = upper_corner - particle.position;
+							double distance_x = (x == 1) ? 0.0 : ((x == 0) ? lower.x : upper.x);
+							double distance_y = (y == 1) ? 0.0 : ((y == 0) ? lower.y : upper.y);
+							double distance_z = (z == 1) ? 0.0 : ((z == 0) ? lower.z : upper.z);
+							if (distance_x * distance_x + distance_y * distance_y + distance_z * distance_z > rim_width_squared) {
+								continue;
+							}
+						}
+						target_particles.push_back(&particle);
 					}
 				}
 			}
 		}
 	}
+
+	std::unordered_map<int, std::vector<SphParticle*>> target_map;
+	for (int i = 0; i < 27; i++) {
+		if (!rim_particles[i].empty()) {
+			target_map[neighbour_domain_ids[i]] = std::move(rim_particles[i]);
+		}
+	}
 	return target_map;
 }
@@ -6,6 +6,8 @@
 #include "../simulation/SimulationUtilities.h"
 
 #include <vector>
+#include <array>
+#include <algorithm>
 #include <iterator>
 #include <unordered_map>
 #include <iostream>
@@ -34,12 +36,20 @@ public:
 	void clearNeighbourRimParticles(SphParticle::ParticleType);
 	void addNeighbourRimParticles(const std::unordered_map<int, std::vector<SphParticle*>>&, SphParticle::ParticleType);
 	std::unordered_map<int, std::vector<SphParticle*>> getNeighbourRimParticles();
-	std::unordered_map<int, std::vector<SphParticle*>> getRimParticleTargetMap(SphParticle::ParticleType);
+	std::vector<SphParticle*> getNeighbourRimParticles(SphParticle::ParticleType);
+	// rim particles within rim_width of each neighbour domain, also partitions the particles of the type into their rim regions
+	std::unordered_map<int, std::vector<SphParticle*>> getRimParticleTargetMap(SphParticle::ParticleType, double rim_width);
+	void partitionRimRegions(SphParticle::ParticleType, double rim_width);
+	bool isWithinDistance(const Vector3&, double distance) const;
 
 private:
 	std::unordered_map <SphParticle::ParticleType, std::vector<SphParticle>> particles;
 	std::unordered_map<SphParticle::ParticleType, std::unordered_map<int, std::vector<SphParticle*>>> neighbour_particles;
+	// particles are kept sorted by the 27 regions of faces, edges and corners they are close to, interior is region 13
+	std::unordered_map<SphParticle::ParticleType, std::array<int, 28>> region_offsets;
 
 	Vector3 origin;
 	Vector3 dimensions;
+
+	int computeRimRegion(const Vector3&, double rim_width) const;
 };
\ No newline at end of file
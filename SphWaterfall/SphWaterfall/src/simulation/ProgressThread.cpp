@@ -0,0 +1,37 @@
+#include "ProgressThread.h"
+
+ProgressThread::ProgressThread() :
+	is_running(false)
+{
+}
+
+ProgressThread::~ProgressThread() {
+
+}
+
+void ProgressThread::start(MPI_Comm comm) {
+	if (is_running) {
+		return;
+	}
+	MPI_Comm_dup(comm, &progress_comm);
+	is_running = true;
+	thread = std::thread(&ProgressThread::run, this);
+}
+
+void ProgressThread::stop() {
+	if (!is_running) {
+		return;
+	}
+	is_running = false;
+	thread.join();
+	MPI_Comm_free(&progress_comm);
+}
+
+void ProgressThread::run() {
+	int flag;
+	while (is_running) {
+		// nothing is ever sent on progress_comm, the probe only drives the progress engine
+		MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, progress_comm, &flag, MPI_STATUS_IGNORE);
+		std::this_thread::sleep_for(std::chrono::microseconds(PROGRESS_THREAD_INTERVAL));
+	}
+}
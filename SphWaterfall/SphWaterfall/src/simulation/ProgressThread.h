@@ -0,0 +1,28 @@
+#pragma once
+#include "mpi.h"
+#include "SimulationUtilities.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Background thread that keeps entering the MPI library, so outstanding non-blocking halo and export transfers
+// progress while the process is busy computing. Needs MPI_THREAD_MULTIPLE.
+class ProgressThread {
+public:
+	ProgressThread();
+	~ProgressThread();
+
+	// collective on comm
+	void start(MPI_Comm comm);
+	// collective on the comm given to start
+	void stop();
+
+private:
+	std::thread thread;
+	std::atomic<bool> is_running;
+	// private duplicate, so the probes never match a real message
+	MPI_Comm progress_comm;
+
+	void run();
+};
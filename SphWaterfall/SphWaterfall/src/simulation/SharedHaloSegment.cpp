@@ -0,0 +1,127 @@
+#include "SharedHaloSegment.h"
+
+SharedHaloSegment::SharedHaloSegment() :
+	is_allocated(false),
+	meta_capacity(0),
+	particle_capacity(0)
+{
+}
+
+SharedHaloSegment::~SharedHaloSegment() {
+
+}
+
+void SharedHaloSegment::publish(MPI_Comm node_comm, std::unordered_map<int, std::vector<int>>& outgoing_meta, std::unordered_map<int, std::vector<SphParticle*>>& outgoing_particles) {
+	if (!is_allocated) {
+		MPI_Comm_rank(node_comm, &node_rank);
+		MPI_Comm_size(node_comm, &node_size);
+		allocate(node_comm, 0, 0);
+		is_allocated = true;
+	}
+
+	int meta_needed = 4 * node_size;
+	int particle_needed = 0;
+	for (auto& each_target : outgoing_meta) {
+		meta_needed += static_cast<int>(each_target.second.size());
+	}
+	for (auto& each_target : outgoing_particles) {
+		particle_needed += static_cast<int>(each_target.second.size());
+	}
+
+	// the neighbours must be done with the last published particles before they are overwritten
+	MPI_Barrier(node_comm);
+
+	// window allocation is collective, so every process of the node reallocates as soon as one of them is too small
+	int needs_growth = (meta_needed > meta_capacity || particle_needed > particle_capacity) ? 1 : 0;
+	int any_needs_growth;
+	MPI_Allreduce(&needs_growth, &any_needs_growth, 1, MPI_INT, MPI_LOR, node_comm);
+	if (any_needs_growth != 0) {
+		free();
+		allocate(node_comm, std::max(meta_capacity, meta_needed + meta_needed / 2), std::max(particle_capacity, particle_needed + particle_needed / 2));
+	}
+
+	std::fill(meta_buffer, meta_buffer + 4 * node_size, 0);
+	int meta_offset = 4 * node_size;
+	int particle_offset = 0;
+	for (auto& each_target : outgoing_meta) {
+		std::vector<SphParticle*>& particles = outgoing_particles[each_target.first];
+		int* control = meta_buffer + 4 * each_target.first;
+		control[0] = meta_offset;
+		control[1] = static_cast<int>(each_target.second.size());
+		control[2] = particle_offset;
+		control[3] = static_cast<int>(particles.size());
+
+		std::copy(each_target.second.begin(), each_target.second.end(), meta_buffer + meta_offset);
+		meta_offset += control[1];
+		for (auto& each_ptr : particles) {
+			particle_buffer[particle_offset] = *each_ptr;
+			particle_offset++;
+		}
+	}
+
+	MPI_Win_sync(meta_window);
+	MPI_Win_sync(particle_window);
+	MPI_Barrier(node_comm);
+	MPI_Win_sync(meta_window);
+	MPI_Win_sync(particle_window);
+}
+
+int SharedHaloSegment::read(int source_node_rank, std::vector<int>& meta, SphParticle*& particles) {
+	MPI_Aint size;
+	int disp_unit;
+	int* source_meta;
+	SphParticle* source_particles;
+	MPI_Win_shared_query(meta_window, source_node_rank, &size, &disp_unit, &source_meta);
+	MPI_Win_shared_query(particle_window, source_node_rank, &size, &disp_unit, &source_particles);
+
+	int* control = source_meta + 4 * node_rank;
+	meta = std::vector<int>(source_meta + control[0], source_meta + control[0] + control[1]);
+	particles = source_particles + control[2];
+	return control[3];
+}
+
+void SharedHaloSegment::publishDensities(MPI_Comm node_comm, std::unordered_map<int, std::vector<SphParticle*>>& outgoing_particles) {
+	for (auto& each_target : outgoing_particles) {
+		SphParticle* published = particle_buffer + meta_buffer[4 * each_target.first + 2];
+		for (int i = 0; i < each_target.second.size(); i++) {
+			published[i].local_density = each_target.second[i]->local_density;
+		}
+	}
+
+	MPI_Win_sync(particle_window);
+	MPI_Barrier(node_comm);
+	MPI_Win_sync(particle_window);
+}
+
+void SharedHaloSegment::release() {
+	if (!is_allocated) {
+		return;
+	}
+	free();
+	is_allocated = false;
+	meta_capacity = 0;
+	particle_capacity = 0;
+}
+
+void SharedHaloSegment::allocate(MPI_Comm node_comm, int meta_capacity, int particle_capacity) {
+	this->meta_capacity = meta_capacity;
+	this->particle_capacity = particle_capacity;
+
+	// every process keeps its part in its own numa domain
+	MPI_Info info;
+	MPI_Info_create(&info);
+	MPI_Info_set(info, "alloc_shared_noncontig", "true");
+	MPI_Win_allocate_shared(meta_capacity * sizeof(int), sizeof(int), info, node_comm, &meta_buffer, &meta_window);
+	MPI_Win_allocate_shared(particle_capacity * sizeof(SphParticle), sizeof(SphParticle), info, node_comm, &particle_buffer, &particle_window);
+	MPI_Info_free(&info);
+
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, meta_window);
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, particle_window);
+}
+
+void SharedHaloSegment::free() {
+	MPI_Win_unlock_all(meta_window);
+	MPI_Win_unlock_all(particle_window);
+	MPI_Win_free(&meta_window);
+	MPI_Win_free(&particle_window);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "mpi.h"
+#include "SimulationUtilities.h"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+// Rim particles for the processes of the same node, kept in a MPI-3 shared memory window which the neighbours read in place
+class SharedHaloSegment {
+public:
+	SharedHaloSegment();
+	~SharedHaloSegment();
+
+	// collective on node_comm, target node rank -> meta / rim particles
+	void publish(MPI_Comm node_comm, std::unordered_map<int, std::vector<int>>& outgoing_meta, std::unordered_map<int, std::vector<SphParticle*>>& outgoing_particles);
+	// meta and particles the source node rank published for this process, returns the particle count
+	// the particles stay valid until the source publishes again
+	int read(int source_node_rank, std::vector<int>& meta, SphParticle*& particles);
+	// collective on node_comm, refreshes the densities of the published particles
+	void publishDensities(MPI_Comm node_comm, std::unordered_map<int, std::vector<SphParticle*>>& outgoing_particles);
+	// collective on node_comm, frees the windows
+	void release();
+
+private:
+	bool is_allocated;
+	int node_rank;
+	int node_size;
+	int meta_capacity;
+	int particle_capacity;
+
+	// per target: meta offset, meta count, particle offset, particle count; followed by the meta of all targets
+	MPI_Win meta_window;
+	int* meta_buffer;
+	MPI_Win particle_window;
+	SphParticle* particle_buffer;
+
+	void allocate(MPI_Comm node_comm, int meta_capacity, int particle_capacity);
+	void free();
+};
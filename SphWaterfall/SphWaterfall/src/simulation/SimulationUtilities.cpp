@@ -3,6 +3,7 @@
 namespace SimulationUtilities {
 	MPI_Comm slave_comm;
 	int slave_comm_size;
+	bool use_progress_thread = false;
 
 	int hash(const Vector3& vector) {
 		int x, y, z;
@@ -33,4 +34,81 @@ namespace SimulationUtilities {
 		return abs(computeDomainID(position, domain_dimension) % slave_comm_size);
 	}
 
+	MPI_Datatype getParticleDatatype() {
+		static MPI_Datatype particle_datatype = MPI_DATATYPE_NULL;
+		if (particle_datatype == MPI_DATATYPE_NULL) {
+			MPI_Type_contiguous(sizeof(SphParticle), MPI_BYTE, &particle_datatype);
+			MPI_Type_commit(&particle_datatype);
+		}
+		return particle_datatype;
+	}
+
+	void sendParticles(const SphParticle* particles, long long count, int target, int tag, MPI_Comm comm, bool is_synchronous) {
+#if MPI_VERSION >= 4
+		if (is_synchronous) {
+			MPI_Ssend_c(particles, count, getParticleDatatype(), target, tag, comm);
+		}
+		else {
+			MPI_Send_c(particles, count, getParticleDatatype(), target, tag, comm);
+		}
+#else
+		// an empty transfer is still one message
+		long long offset = 0;
+		do {
+			int chunk = static_cast<int>(std::min<long long>(count - offset, MAX_PARTICLES_PER_MESSAGE));
+			if (is_synchronous) {
+				MPI_Ssend(particles + offset, chunk, getParticleDatatype(), target, tag, comm);
+			}
+			else {
+				MPI_Send(particles + offset, chunk, getParticleDatatype(), target, tag, comm);
+			}
+			offset += chunk;
+		} while (offset < count);
+#endif
+	}
+
+	void receiveParticles(SphParticle* particles, long long count, int source, int tag, MPI_Comm comm) {
+#if MPI_VERSION >= 4
+		MPI_Recv_c(particles, count, getParticleDatatype(), source, tag, comm, MPI_STATUS_IGNORE);
+#else
+		long long offset = 0;
+		do {
+			int chunk = static_cast<int>(std::min<long long>(count - offset, MAX_PARTICLES_PER_MESSAGE));
+			MPI_Recv(particles + offset, chunk, getParticleDatatype(), source, tag, comm, MPI_STATUS_IGNORE);
+			offset += chunk;
+		} while (offset < count);
+#endif
+	}
+
+	void postParticleReceives(SphParticle* particles, long long count, int source, int tag, MPI_Comm comm, std::vector<MPI_Request>& requests) {
+#if MPI_VERSION >= 4
+		requests.emplace_back();
+		MPI_Irecv_c(particles, count, getParticleDatatype(), source, tag, comm, &requests.back());
+#else
+		// messages between two processes with the same tag are not overtaking, so the chunks arrive in order
+		long long offset = 0;
+		do {
+			int chunk = static_cast<int>(std::min<long long>(count - offset, MAX_PARTICLES_PER_MESSAGE));
+			requests.emplace_back();
+			MPI_Irecv(particles + offset, chunk, getParticleDatatype(), source, tag, comm, &requests.back());
+			offset += chunk;
+		} while (offset < count);
+#endif
+	}
+
+	void postParticleSends(const SphParticle* particles, long long count, int target, int tag, MPI_Comm comm, std::vector<MPI_Request>& requests) {
+#if MPI_VERSION >= 4
+		requests.emplace_back();
+		MPI_Isend_c(particles, count, getParticleDatatype(), target, tag, comm, &requests.back());
+#else
+		long long offset = 0;
+		do {
+			int chunk = static_cast<int>(std::min<long long>(count - offset, MAX_PARTICLES_PER_MESSAGE));
+			requests.emplace_back();
+			MPI_Isend(particles + offset, chunk, getParticleDatatype(), target, tag, comm, &requests.back());
+			offset += chunk;
+		} while (offset < count);
+#endif
+	}
+
 }
@@ -3,6 +3,11 @@
 #include "../data/Vector3.h"
 #include "../data/SphParticle.h"
 
+#include <vector>
+#include <algorithm>
+
+class SphParticle;
+
 // for checking if a double is 0
 #define EPSILON 1e-6
 
@@ -32,6 +37,44 @@
 #define DEFAULT_SIMULATION_TIME 100
 // time in seconds one timestep takes
 #define TIMESTEP_DURATION 0.03
+// timesteps between two summations of the densities in continuity density mode
+#define DENSITY_REINITIALIZATION_INTERVAL 20
+
+// microseconds between two polls of the communication progress thread
+#define PROGRESS_THREAD_INTERVAL 50
+
+// particles per message, keeps every message below 2 GiB
+#define MAX_PARTICLES_PER_MESSAGE 16777216
+
+// default number of exported frames that may be in flight before the simulation waits for the master
+#define EXPORT_QUEUE_LENGTH 3
+
+// doubles per particle in binary particle files: position, velocity, mass
+#define PARTICLE_RECORD_SIZE 7
+// with the id as 64 bit integer in the place of an eighth double
+#define PARTICLE_RECORD_SIZE_WITH_ID 8
+
+// particle ids carry the slave rank + 1 above this bit and a counter of the creating process below,
+// so they stay unique over all processes without a global counter
+#define PARTICLE_ID_RANK_SHIFT 40
+// ids of the particles that stand for the interior of a cell in surface-only exports, the cell id below
+#define INTERIOR_CELL_ID_FLAG (1ull << 63)
+
+// free surface classification: fewer neighbours than this, or a colour field gradient relative to the colour field above this times 1 / H
+#define SURFACE_NEIGHBOUR_COUNT 20
+#define SURFACE_COLOUR_GRADIENT 0.5
+
+// resolution of the quantised deltas of the halo codec, a transmitted value is off by at most half of it
+#define HALO_CODEC_POSITION_QUANTUM (1.0 / 1048576.0)
+#define HALO_CODEC_VELOCITY_QUANTUM (1.0 / 1048576.0)
+#define HALO_CODEC_DENSITY_QUANTUM (1.0 / 1048576.0)
+// rim exchanges between two exact full transmissions of the halo codec
+#define HALO_CODEC_REFRESH_INTERVAL 10
+
+// default error of compressed frames relative to the extent of the bounding box of a frame
+#define FRAME_CODEC_TOLERANCE 1e-5
+// compressed frames between two frames that are decoded without the previous one
+#define FRAME_CODEC_KEYFRAME_INTERVAL 32
 
 // Sph Manager tags
 #define META_RIM_TAG 0
@@ -50,6 +93,17 @@ namespace SimulationUtilities {
 	int computeProcessID(const int domain_id);
 	int computeDomainID(const Vector3& position, const Vector3& domain_dimension);
 
+	// one SphParticle as raw bytes, created on first use
+	MPI_Datatype getParticleDatatype();
+	// particle transfers with 64 bit counts, split into messages of at most MAX_PARTICLES_PER_MESSAGE particles
+	// or sent as one message with the large count functions of MPI-4
+	void sendParticles(const SphParticle* particles, long long count, int target, int tag, MPI_Comm comm, bool is_synchronous = false);
+	void receiveParticles(SphParticle* particles, long long count, int source, int tag, MPI_Comm comm);
+	void postParticleReceives(SphParticle* particles, long long count, int source, int tag, MPI_Comm comm, std::vector<MPI_Request>& requests);
+	void postParticleSends(const SphParticle* particles, long long count, int target, int tag, MPI_Comm comm, std::vector<MPI_Request>& requests);
+
 	extern MPI_Comm slave_comm;
 	extern int slave_comm_size;
+	// set at startup when MPI was initialized with MPI_THREAD_MULTIPLE for the progress thread
+	extern bool use_progress_thread;
 }
\ No newline at end of file
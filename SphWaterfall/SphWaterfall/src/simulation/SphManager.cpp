@@ -2,12 +2,36 @@
 #include <chrono>
 #include <thread>
 
+// set by the signal handler, a checkpoint is written after the current timestep
+static volatile std::sig_atomic_t checkpoint_requested = 0;
+
 SphManager::SphManager(const Vector3& domain_dimensions) :
 	domain_dimensions(domain_dimensions),
+	cell_dimensions(domain_dimensions),
 	gravity_acceleration(Vector3(0.0, -9.81, 0.0)),
-	sink_height(0.0)
+	sink_height(0.0),
+	shutter_timestep(-1),
+	halo_exchange_mode(TWO_SIDED),
+	use_shared_memory(false),
+	use_double_ghost_layer(false),
+	density_mode(SUMMATION_DENSITY),
+	use_halo_codec(false),
+	export_mode(MASTER_EXPORT),
+	export_queue_length(EXPORT_QUEUE_LENGTH),
+	frame_format(TEXT_FRAMES),
+	frame_tolerance(FRAME_CODEC_TOLERANCE),
+	use_frame_ids(false),
+	vtk_format(LEGACY_VTK),
+	particle_id_count(0),
+	first_timestep(1),
+	progress_thread(nullptr)
 {
 	half_timestep_duration = TIMESTEP_DURATION / 2.0;
+	// the master isn't part of slave_comm
+	mpi_rank = -1;
+	if (slave_comm != MPI_COMM_NULL) {
+		MPI_Comm_rank(slave_comm, &mpi_rank);
+	}
 
 	kernel = kernel_factory.getInstance(1);
 	neighbour_search = neighbour_search_factory.getInstance(1);
@@ -61,6 +85,29 @@ void SphManager::simulate(int number_of_timesteps) {
 		std::cout << "prepare simulation..." << std::endl;
 	}
 
+	if (use_shared_memory) {
+		createNodeCommunicator();
+	}
+
+
+	if (export_mode == MPIIO_EXPORT) {
+		particle_writer.open(slave_comm, "sph.pbin", use_frame_ids);
+	}
+	vtk_time_series.clear();
+	if (mpi_rank == 0 && output_scheduler.countDue(OutputScheduler::STATISTICS_STREAM, first_timestep, number_of_timesteps) != 0) {
+		std::ofstream statistics_file("statistics.csv");
+		statistics_file << "timestep,time,particles,mean_speed,max_speed,mean_density,kinetic_energy\n";
+	}
+	export_slot = 0;
+	export_buffers.resize(export_queue_length);
+	export_counts.resize(export_queue_length);
+	export_requests.resize(export_queue_length);
+
+	if (use_progress_thread) {
+		progress_thread = new ProgressThread();
+		progress_thread->start(slave_comm);
+	}
+
 	exchangeParticles();
 	if (mpi_rank == 0) {
 		std::cout << "finished static exchange" << std::endl;
@@ -74,13 +121,16 @@ void SphManager::simulate(int number_of_timesteps) {
 
 	if (mpi_rank == 0) {
 		std::cout << "starting simulation..." << std::endl;
+		if (first_timestep > 1) {
+			std::cout << "resuming at timestep " << first_timestep << std::endl;
+		}
 	}
 
 	int exchange_rim_particles_time, update_particles_time, spawn_particle_time, exchange_particles_time, export_particles_time, simulation_timestep_time;
 	std::chrono::steady_clock::time_point begin, end;
 
 	std::cout << number_of_timesteps << std::endl;
-	for (int simulation_timestep = 1; simulation_timestep <= number_of_timesteps; simulation_timestep++) {
+	for (int simulation_timestep = first_timestep; simulation_timestep <= number_of_timesteps; simulation_timestep++) {
 		if (simulation_timestep == this->shutter_timestep) {
 			//Remove shutter particles
 			MPI_Barrier(slave_comm);
@@ -100,7 +150,7 @@ void SphManager::simulate(int number_of_timesteps) {
 			std::cout << "finished rim exchange in " << exchange_rim_particles_time << "ms"<< std::endl;
 			begin = std::chrono::steady_clock::now();
 		}
-		update();
+		update(simulation_timestep);
 		MPI_Barrier(slave_comm);
 		if (mpi_rank == 0) {
 			end = std::chrono::steady_clock::now();
@@ -124,7 +174,16 @@ void SphManager::simulate(int number_of_timesteps) {
 			std::cout << "finished exchange in " << exchange_particles_time << "ms" << std::endl;
 			begin = std::chrono::steady_clock::now();
 		}
-		exportParticles();
+		exportParticles(simulation_timestep);
+		if (output_scheduler.isDue(OutputScheduler::STATISTICS_STREAM, simulation_timestep)) {
+			writeStatistics(simulation_timestep);
+		}
+		if (isCheckpointDue(simulation_timestep)) {
+			writeCheckpoint(simulation_timestep);
+		}
+		else {
+			checkpoint_writer.progress();
+		}
 		MPI_Barrier(slave_comm);
 		if (mpi_rank == 0) {
 			end = std::chrono::steady_clock::now();
@@ -136,7 +195,81 @@ void SphManager::simulate(int number_of_timesteps) {
 		}
 	}
 
+	waitForExports();
+	checkpoint_writer.finish();
+	first_timestep = 1;
 	cleanUpFluidParticles();
+	particle_writer.close();
+	if (mpi_rank == 0 && !vtk_time_series.empty()) {
+		ParticleIO::exportPVD("vtk/particles.pvd", vtk_time_series);
+	}
+	halo_window.release();
+	for (auto& each_plan : halo_plans) {
+		each_plan.second.release();
+	}
+	if (use_halo_codec) {
+		long long halo_bytes[2] = { 0, 0 };
+		for (auto& each_codec : halo_codecs) {
+			halo_bytes[0] += each_codec.second.getRawBytes();
+			halo_bytes[1] += each_codec.second.getEncodedBytes();
+			each_codec.second.reset();
+		}
+		long long total_halo_bytes[2];
+		MPI_Reduce(halo_bytes, total_halo_bytes, 2, MPI_LONG_LONG, MPI_SUM, 0, slave_comm);
+		if (mpi_rank == 0 && total_halo_bytes[1] != 0) {
+			std::cout << "halo codec sent " << total_halo_bytes[1] << " bytes instead of " << total_halo_bytes[0]
+				<< " (ratio " << static_cast<double>(total_halo_bytes[0]) / total_halo_bytes[1] << ")" << std::endl;
+		}
+	}
+	if (use_shared_memory) {
+		freeNodeCommunicator();
+	}
+	if (progress_thread != nullptr) {
+		progress_thread->stop();
+		delete progress_thread;
+		progress_thread = nullptr;
+	}
+}
+
+void SphManager::createNodeCommunicator() {
+	MPI_Comm_split_type(slave_comm, MPI_COMM_TYPE_SHARED, mpi_rank, MPI_INFO_NULL, &node_comm);
+
+	int node_size;
+	MPI_Comm_size(node_comm, &node_size);
+	std::vector<int> node_rank_list(node_size);
+	std::vector<int> slave_rank_list(node_size);
+	for (int i = 0; i < node_size; i++) {
+		node_rank_list[i] = i;
+	}
+
+	MPI_Group slave_group, node_group;
+	MPI_Comm_group(slave_comm, &slave_group);
+	MPI_Comm_group(node_comm, &node_group);
+	MPI_Group_translate_ranks(node_group, node_size, node_rank_list.data(), slave_group, slave_rank_list.data());
+	MPI_Group_free(&slave_group);
+	MPI_Group_free(&node_group);
+
+	node_ranks.clear();
+	for (int i = 0; i < node_size; i++) {
+		node_ranks[slave_rank_list[i]] = i;
+	}
+
+	if (mpi_rank == 0) {
+		std::cout << "exchanging with " << node_size - 1 << " processes through shared memory" << std::endl;
+	}
+}
+
+void SphManager::freeNodeCommunicator() {
+	// window release is collective, keep the same order on all processes
+	shared_segments[SphParticle::STATIC].release();
+	shared_segments[SphParticle::FLUID].release();
+	migration_segment.release();
+	MPI_Comm_free(&node_comm);
+	node_ranks.clear();
+}
+
+bool SphManager::isRemoteProcess(int process_id) {
+	return process_id != mpi_rank && (!use_shared_memory || node_ranks.count(process_id) == 0);
 }
 
 std::vector<SphParticle> SphManager::getNeighbours(int index)
@@ -148,8 +281,9 @@ std::vector<SphParticle> SphManager::getNeighbours(int index)
 	return result;
 }
 
-void SphManager::update() {
-	int neighbour_search_time, local_density_calculation_time, local_density_exchange_time, velocity_and_position_update_time;
+void SphManager::update(int simulation_timestep) {
+	int neighbour_search_time, velocity_and_position_update_time;
+	bool is_summation_step = (density_mode == SUMMATION_DENSITY) || ((simulation_timestep - 1) % DENSITY_REINITIALIZATION_INTERVAL == 0);
 	std::chrono::steady_clock::time_point begin, end;
 
 	if (mpi_rank == 0) {
@@ -158,30 +292,45 @@ void SphManager::update() {
 
 	// neighbour search
 	std::vector<SphParticle*> each_neighbour_particles;
-	std::unordered_map <int, std::vector<SphParticle*>> each_neighbour_rim_particles;
+	std::unordered_map<int, std::vector<SphParticle*>> cells;
 
 	neighbour_particles.clear();
+	ghost_particles.clear();
+	ghost_neighbour_particles.clear();
 
 	MPI_Barrier(slave_comm);
 	for (auto& each_domain : domains) {
 		if (each_domain.second.hasParticles(SphParticle::FLUID)) {
-			// gets neighbour particle map from domain
-			each_neighbour_rim_particles = each_domain.second.getNeighbourRimParticles();
+			// sorts the particles of the domain and its neighbour rim particles into the neighbour search cells, a domain may span many of them
+			cells.clear();
+			for (auto& each_particle : each_domain.second.getParticles()) {
+				cells[computeDomainID(each_particle->position, cell_dimensions)].push_back(each_particle);
+			}
+			for (auto& each_neighbour_rim_particles : each_domain.second.getNeighbourRimParticles()) {
+				for (auto& each_particle : each_neighbour_rim_particles.second) {
+					cells[computeDomainID(each_particle->position, cell_dimensions)].push_back(each_particle);
+				}
+			}
 
 			for (auto& each_particle : each_domain.second.getFluidParticles()) {
-				// gets particles of domain the particle is in
-				each_neighbour_particles = each_domain.second.getParticles();
+				// gets particles of the cell the particle is in
+				int cell_id = computeDomainID(each_particle.position, cell_dimensions);
+				each_neighbour_particles = cells[cell_id];
 
-				for (auto& domain_id : neighbour_search->findRelevantNeighbourDomains(each_particle.position, domain_dimensions)) {
-					// tests if domain of particle has neighbour particles for currently looked at neighbour domain
-					if (!each_neighbour_rim_particles[domain_id].empty()) {
+				for (auto& neighbour_cell_id : neighbour_search->findRelevantNeighbourDomains(each_particle.position, cell_dimensions)) {
+					// tests if the currently looked at neighbour cell has particles
+					if (neighbour_cell_id != cell_id && cells.count(neighbour_cell_id) != 0) {
 						each_neighbour_particles.insert(each_neighbour_particles.end(),
-							each_neighbour_rim_particles[domain_id].begin(),
-							each_neighbour_rim_particles[domain_id].end());
+							cells.at(neighbour_cell_id).begin(),
+							cells.at(neighbour_cell_id).end());
 					}
 				}
 				neighbour_particles.push_back(neighbour_search->findNeigbours(each_particle.position, each_neighbour_particles));
 			}
+
+			if (use_double_ghost_layer && is_summation_step) {
+				findGhostNeighbours(each_domain.second, cells);
+			}
 		}
 	}
 	MPI_Barrier(slave_comm);
@@ -192,42 +341,20 @@ void SphManager::update() {
 		begin = std::chrono::steady_clock::now();
 	}
 	MPI_Barrier(slave_comm);
-	// compute and set local densities
-	int index = 0;
-	for (auto& each_domain : domains) {
-		for (auto& each_particle : each_domain.second.getFluidParticles()) {
-            auto n = getNeighbours(index);
-			computeLocalDensity(each_particle, n);
-			index++;
-		}
+	// summation density every step or only to reinitialize the integrated densities
+	if (is_summation_step) {
+		computeDensities();
 	}
 
-	index = 0;
-	for (auto& each_domain : domains) {
-		for (auto& each_particle : each_domain.second.getFluidParticles()) {
-			//filterLocalDensity(each_particle, getNeighbours(index));
-			index++;
-		}
-	}
-	MPI_Barrier(slave_comm);
 	if (mpi_rank == 0) {
-		end = std::chrono::steady_clock::now();
-		local_density_calculation_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
-		std::cout << "finished density calculation in " << local_density_calculation_time << "ms" << std::endl;
 		begin = std::chrono::steady_clock::now();
 	}
-	MPI_Barrier(slave_comm);
-	exchangeRimDensity(SphParticle::FLUID);
 
-	if (mpi_rank == 0) {
-		end = std::chrono::steady_clock::now();
-		local_density_exchange_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
-		std::cout << "finished density exchange in " << local_density_exchange_time << "ms" << std::endl;
-		begin = std::chrono::steady_clock::now();
-	}
-	
+	// surface-only exports of this timestep need the particles classified before they move
+	bool is_classification_step = output_scheduler.isSurfaceDue(simulation_timestep);
+
 	// compute and update Velocities and position
-	index = 0;
+	int index = 0;
 	std::vector<std::vector<SphParticle>> neighbour_list;
 	for (auto& each_domain : domains) {
 		std::vector<SphParticle> &particles = each_domain.second.getFluidParticles();
@@ -242,11 +369,22 @@ void SphManager::update() {
 		if (each_domain.second.hasParticles(SphParticle::FLUID)) {
 			std::vector<SphParticle> &particles = each_domain.second.getFluidParticles();
 			for (int i = 0; i < particles.size(); i++) {
+				// the density change uses the velocities at the start of the timestep
+				double density_rate = 0.0;
+				if (!is_summation_step) {
+					density_rate = computeDensityRate(particles.at(i), neighbour_list[index]);
+				}
+				if (is_classification_step) {
+					classifySurface(particles.at(i), neighbour_list[index]);
+				}
 				if (updateVelocity(particles.at(i), neighbour_list[index])) {
 					particles.erase(particles.begin() + i);
 					--i;
 					//std::cout << "final particle: " << each_particle << " on processor " << mpi_rank + 1 << std::endl; // debug
 				}
+				else if (!is_summation_step) {
+					particles.at(i).local_density = std::max(FLUID_REFERENCE_DENSITY, particles.at(i).local_density + TIMESTEP_DURATION * density_rate);
+				}
 				index++;
 			}
 		}
@@ -261,6 +399,87 @@ void SphManager::update() {
 	
 }
 
+void SphManager::findGhostNeighbours(ParticleDomain& domain, std::unordered_map<int, std::vector<SphParticle*>>& cells) {
+	std::vector<SphParticle*> each_neighbour_particles;
+	for (auto& each_ghost : domain.getNeighbourRimParticles(SphParticle::FLUID)) {
+		// rim particles of domains on this process get their density with the domain they belong to,
+		// the second ghost layer is only needed as neighbours of the first
+		if (computeProcessID(each_ghost->position, domain_dimensions) == mpi_rank || !domain.isWithinDistance(each_ghost->position, Q_MAX)) {
+			continue;
+		}
+
+		each_neighbour_particles.clear();
+		for (auto& neighbour_cell_id : neighbour_search->findRelevantNeighbourDomains(each_ghost->position, cell_dimensions)) {
+			if (cells.count(neighbour_cell_id) != 0) {
+				each_neighbour_particles.insert(each_neighbour_particles.end(),
+					cells.at(neighbour_cell_id).begin(),
+					cells.at(neighbour_cell_id).end());
+			}
+		}
+		ghost_particles.push_back(each_ghost);
+		ghost_neighbour_particles.push_back(neighbour_search->findNeigbours(each_ghost->position, each_neighbour_particles));
+	}
+}
+
+void SphManager::computeDensities() {
+	// compute and set local densities
+	int local_density_calculation_time, local_density_exchange_time;
+	std::chrono::steady_clock::time_point begin, end;
+
+	if (mpi_rank == 0) {
+		begin = std::chrono::steady_clock::now();
+	}
+
+	int index = 0;
+	for (auto& each_domain : domains) {
+		for (auto& each_particle : each_domain.second.getFluidParticles()) {
+            auto n = getNeighbours(index);
+			computeLocalDensity(each_particle, n);
+			index++;
+		}
+	}
+
+	index = 0;
+	for (auto& each_domain : domains) {
+		for (auto& each_particle : each_domain.second.getFluidParticles()) {
+			//filterLocalDensity(each_particle, getNeighbours(index));
+			index++;
+		}
+	}
+	MPI_Barrier(slave_comm);
+	if (mpi_rank == 0) {
+		end = std::chrono::steady_clock::now();
+		local_density_calculation_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+		std::cout << "finished density calculation in " << local_density_calculation_time << "ms" << std::endl;
+		begin = std::chrono::steady_clock::now();
+	}
+	MPI_Barrier(slave_comm);
+	if (use_double_ghost_layer) {
+		// the received rim particles bring their own neighbours along, so their densities are computed here instead of exchanged
+		for (int i = 0; i < ghost_particles.size(); i++) {
+			std::vector<SphParticle> ghost_neighbours;
+			for (auto& each_ptr : ghost_neighbour_particles[i]) {
+				ghost_neighbours.push_back(*each_ptr);
+			}
+			computeLocalDensity(*ghost_particles[i], ghost_neighbours);
+		}
+	}
+	else {
+		exchangeRimDensity(SphParticle::FLUID);
+	}
+
+	if (mpi_rank == 0) {
+		end = std::chrono::steady_clock::now();
+		local_density_exchange_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+		if (use_double_ghost_layer) {
+			std::cout << "finished ghost density calculation in " << local_density_exchange_time << "ms" << std::endl;
+		}
+		else {
+			std::cout << "finished density exchange in " << local_density_exchange_time << "ms" << std::endl;
+		}
+	}
+}
+
 bool SphManager::updateVelocity(SphParticle& particle, std::vector<SphParticle>& neighbours) {
 	Vector3 accelleration_timestep_start = computeAcceleration(particle, neighbours);
 	particle.velocity += (half_timestep_duration * accelleration_timestep_start);
@@ -339,6 +558,19 @@ Vector3 SphManager::computeViscosityAcceleration(SphParticle& particle, std::vec
 	return viscosity_acceleration;
 }
 
+void SphManager::classifySurface(SphParticle& particle, std::vector<SphParticle>& neighbours) {
+	// gradient of the colour field, which is 1 inside the fluid and the walls and 0 outside, divided by the colour field itself.
+	// The fluid is compressed unevenly and the walls have another mass, so every neighbour counts with the same volume,
+	// which cancels. About 1 at the free surface, 0 one smoothing length below it
+	Vector3 colour_gradient = Vector3();
+	double colour = kernel->computeKernelValue(Vector3());
+	for (SphParticle& neighbour_particle : neighbours) {
+		colour_gradient += kernel->computeKernelGradientValue(particle.position - neighbour_particle.position);
+		colour += kernel->computeKernelValue(particle.position - neighbour_particle.position);
+	}
+	particle.setSurface(neighbours.size() < SURFACE_NEIGHBOUR_COUNT || colour_gradient.length() * H / colour > SURFACE_COLOUR_GRADIENT);
+}
+
 void SphManager::computeLocalDensity(SphParticle& particle, std::vector<SphParticle>& neighbours) {
 	double local_density = 0.0;
 
@@ -355,6 +587,15 @@ void SphManager::computeLocalDensity(SphParticle& particle, std::vector<SphParti
 	}
 }
 
+double SphManager::computeDensityRate(SphParticle& particle, std::vector<SphParticle>& neighbours) {
+	// continuity equation, the density changes with the divergence of the velocity
+	double density_rate = 0.0;
+	for (SphParticle& neighbour_particle : neighbours) {
+		density_rate += neighbour_particle.mass * (particle.velocity - neighbour_particle.velocity).dot(kernel->computeKernelGradientValue(particle.position - neighbour_particle.position));
+	}
+	return density_rate;
+}
+
 void SphManager::filterLocalDensity(SphParticle& particle, std::vector<SphParticle>& neighbours) {
 	double shepard_divider = 0.0;
 	for (SphParticle& neighbour_particle : neighbours) {
@@ -412,27 +653,34 @@ void SphManager::exchangeParticles() {
 		all_new_particles = target_map.at(mpi_rank);
 		target_map.erase(mpi_rank);
 	}
+
+	// processes on the same node hand over their particles through shared memory
+	if (use_shared_memory) {
+		exchangeParticlesShared(target_map, incoming_particles);
+	}
 	//std::cout << mpi_rank << " started exchange" << std::endl;
 
-	// send meta data
+	// send meta data, the sizes must stay valid until the sends are done
+	std::vector<long long> size_list(slave_comm_size);
+	std::vector<MPI_Request> size_requests;
 	for (int i = 0; i < slave_comm_size; i++) {
-		int size = target_map[i].size();
-		if (i != mpi_rank) {
-			MPI_Request request;
-			MPI_Isend(&size, 1, MPI_INT, i, META_EXCHANGE_TAG, slave_comm, &request);
+		size_list[i] = static_cast<long long>(target_map[i].size());
+		if (isRemoteProcess(i)) {
+			size_requests.emplace_back();
+			MPI_Isend(&size_list[i], 1, MPI_LONG_LONG, i, META_EXCHANGE_TAG, slave_comm, &size_requests.back());
 		}
 	}
 	//std::cout << mpi_rank << " finished sending meta" << std::endl;
 
 	// receive meta from all other processors and post receives
+	std::vector<MPI_Request> receive_requests;
 	for (int i = 0; i < slave_comm_size; i++) {
-		if (i != mpi_rank) {
-			int size;
-			MPI_Recv(&size, 1, MPI_INT, i, META_EXCHANGE_TAG, slave_comm, MPI_STATUS_IGNORE);
+		if (isRemoteProcess(i)) {
+			long long size;
+			MPI_Recv(&size, 1, MPI_LONG_LONG, i, META_EXCHANGE_TAG, slave_comm, MPI_STATUS_IGNORE);
 			if (size != 0) {
 				incoming_particles.push_back(std::vector<SphParticle>(size));
-				MPI_Request request;
-				MPI_Irecv(incoming_particles.back().data(), size * sizeof(SphParticle), MPI_BYTE, i, EXCHANGE_TAG, slave_comm, &request);
+				postParticleReceives(incoming_particles.back().data(), size, i, EXCHANGE_TAG, slave_comm, receive_requests);
 			}
 		}
 	}
@@ -440,10 +688,12 @@ void SphManager::exchangeParticles() {
 	// send particles
 	for (auto& vector : target_map) {
 		if (vector.second.size() != 0) {
-			MPI_Ssend(vector.second.data(), vector.second.size() * sizeof(SphParticle), MPI_BYTE, vector.first, EXCHANGE_TAG, slave_comm);
+			sendParticles(vector.second.data(), static_cast<long long>(vector.second.size()), vector.first, EXCHANGE_TAG, slave_comm, true);
 		}
 	}
 	//std::cout << mpi_rank << " finished sending particles" << std::endl;
+	MPI_Waitall(static_cast<int>(size_requests.size()), size_requests.data(), MPI_STATUSES_IGNORE);
+	MPI_Waitall(static_cast<int>(receive_requests.size()), receive_requests.data(), MPI_STATUSES_IGNORE);
 	MPI_Barrier(slave_comm);
 	add_particles(all_new_particles);
 	for (auto& each_new_particle_list : incoming_particles) {
@@ -451,16 +701,51 @@ void SphManager::exchangeParticles() {
 	}
 }
 
+void SphManager::exchangeParticlesShared(std::unordered_map<int, std::vector<SphParticle>>& target_map, std::vector<std::vector<SphParticle>>& incoming_particles) {
+	std::unordered_map<int, std::vector<int>> outgoing_meta;
+	std::unordered_map<int, std::vector<SphParticle*>> outgoing_particles;
+
+	for (auto& each_node_process : node_ranks) {
+		if (each_node_process.first != mpi_rank) {
+			outgoing_meta[each_node_process.second] = std::vector<int>();
+			for (auto& each_particle : target_map[each_node_process.first]) {
+				outgoing_particles[each_node_process.second].push_back(&each_particle);
+			}
+		}
+	}
+	migration_segment.publish(node_comm, outgoing_meta, outgoing_particles);
+
+	for (auto& each_node_process : node_ranks) {
+		if (each_node_process.first != mpi_rank) {
+			target_map.erase(each_node_process.first);
+
+			std::vector<int> meta;
+			SphParticle* particles;
+			int count = migration_segment.read(each_node_process.second, meta, particles);
+			if (count != 0) {
+				incoming_particles.push_back(std::vector<SphParticle>(particles, particles + count));
+			}
+		}
+	}
+}
+
 void SphManager::exchangeRimParticles(SphParticle::ParticleType particle_type) {
 	// target domain id, source domain id, rim particles from source in direction of target domain
 	std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>> target_source_map;
 	std::unordered_map<int, std::vector<int>> meta_map;
-	std::vector<int> size_list;
 	std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>> new_rim_particles;
 	int source_domain_id;
+	double rim_width = use_double_ghost_layer ? 2.0 * Q_MAX : Q_MAX;
 
 	process_map[particle_type].clear();
+	if (halo_exchange_mode == PERSISTENT) {
+		halo_plans[particle_type].reclaim(incoming[particle_type]);
+	}
 	incoming[particle_type].clear();
+	// keeps the capacity of the send buffers from the last timestep
+	for (auto& each_send_buffer : send_buffers[particle_type]) {
+		each_send_buffer.second.clear();
+	}
 
 	//std::cout << mpi_rank << "start rim exchange" << std::endl; //debug
 
@@ -468,7 +753,7 @@ void SphManager::exchangeRimParticles(SphParticle::ParticleType particle_type) {
 		each_domain.second.clearNeighbourRimParticles(particle_type);
 		if (each_domain.second.hasParticles(particle_type)) {
 			source_domain_id = each_domain.first;
-			for (auto& each_target : each_domain.second.getRimParticleTargetMap(particle_type)) {
+			for (auto& each_target : each_domain.second.getRimParticleTargetMap(particle_type, rim_width)) {
 				if (!each_target.second.empty()) {
 					int target_process_id = computeProcessID(each_target.first);
 					if (target_process_id == mpi_rank) {
@@ -482,20 +767,83 @@ void SphManager::exchangeRimParticles(SphParticle::ParticleType particle_type) {
 		}
 	}
 
-	//std::cout << mpi_rank << "before send meta meta" << std::endl; //debug
+	// processes on the same node read the rim particles in place, all others get messages
+	std::unordered_map<int, SphParticle*> shared_particles;
+	if (use_shared_memory) {
+		exchangeRimParticlesShared(particle_type, target_source_map, meta_map, shared_particles);
+
+		// ghost densities are written into the received particles, so they need a private copy
+		if (use_double_ghost_layer) {
+			for (auto& each_shared : shared_particles) {
+				int count = 0;
+				for (int i = 2; i < meta_map[each_shared.first].size(); i += 3) {
+					count += meta_map[each_shared.first][i];
+				}
+				incoming[particle_type][each_shared.first] = std::vector<SphParticle>(each_shared.second, each_shared.second + count);
+			}
+			shared_particles.clear();
+		}
+	}
+
+	if (halo_exchange_mode == ONE_SIDED) {
+		exchangeRimParticlesOneSided(particle_type, target_source_map, meta_map);
+	}
+	else if (halo_exchange_mode == PERSISTENT) {
+		exchangeRimParticlesPersistent(particle_type, target_source_map, meta_map);
+	}
+	else {
+		exchangeRimParticlesTwoSided(particle_type, target_source_map, meta_map);
+	}
 
-	// send meta meta data	
+	for (auto& each_meta : meta_map) {
+		int process_id = each_meta.first;
+		if (process_id != mpi_rank) {
+			SphParticle* received_particles = (shared_particles.count(process_id) != 0) ? shared_particles.at(process_id) : incoming[particle_type][process_id].data();
+			int meta_count = each_meta.second.size() / 3;
+			int total_count = 0;
+			for (int i = 0; i < meta_count; i++) {
+				int target = each_meta.second[i * 3];
+				int source = each_meta.second[1 + i * 3];
+				int count = each_meta.second[2 + i * 3];
+				for (int j = 0; j < count; j++) {
+					new_rim_particles[target][source].push_back(received_particles + total_count + j);
+				}
+				total_count += count;
+			}
+		}
+	}
+
+	//std::cout << mpi_rank << " finished building new map" << std::endl;
+
+	for (auto& target : new_rim_particles) {
+		if (domains.count(target.first) != 0) {
+			getParticleDomain(target.first).addNeighbourRimParticles(target.second, particle_type);
+		}
+	}
+
+	//std::cout << mpi_rank << " finished giving new map to domains" << std::endl;
+}
+
+void SphManager::exchangeRimParticlesTwoSided(SphParticle::ParticleType particle_type,
+	std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>>& target_source_map,
+	std::unordered_map<int, std::vector<int>>& meta_map) {
+	std::vector<int> size_list;
+	// pointers into size_list are handed to MPI_Isend, so it must not reallocate
+	size_list.reserve(slave_comm_size);
+
+	// send meta meta data, the sizes must stay valid until the sends are done
+	std::vector<MPI_Request> meta_requests;
 	for (int i = 0; i < slave_comm_size; i++) {
-		if (i != mpi_rank) {
+		if (isRemoteProcess(i)) {
 			int size = 0;
 			for (auto& target : target_source_map[i]) {
 				size += static_cast<int>(target.second.size());
 			}
 			size_list.push_back(size);
 
-			MPI_Request request;
+			meta_requests.emplace_back();
 			//std::cout << mpi_rank << " send meta meta for " << size_list.back() << " to " << i << std::endl;
-			MPI_Isend(&size_list.back(), 1, MPI_INT, i, META_META_RIM_TAG, slave_comm, &request);
+			MPI_Isend(&size_list.back(), 1, MPI_INT, i, META_META_RIM_TAG, slave_comm, &meta_requests.back());
 		}
 	}
 
@@ -503,53 +851,51 @@ void SphManager::exchangeRimParticles(SphParticle::ParticleType particle_type) {
 
 	// receive meta meta from all other processors and post meta receives
 	for (int i = 0; i < slave_comm_size; i++) {
-		if (i != mpi_rank) {
+		if (isRemoteProcess(i)) {
 			int meta_count;
-			MPI_Request request;
 			MPI_Recv(&meta_count, 1, MPI_INT, i, META_META_RIM_TAG, slave_comm, MPI_STATUS_IGNORE);
 			meta_map[i] = std::vector<int>(meta_count * 3);
-			MPI_Irecv(meta_map[i].data(), 3 * meta_count, MPI_INT, i, META_RIM_TAG, slave_comm, &request);
+			meta_requests.emplace_back();
+			MPI_Irecv(meta_map[i].data(), 3 * meta_count, MPI_INT, i, META_RIM_TAG, slave_comm, &meta_requests.back());
 			//std::cout << mpi_rank << " post meta receive size " << 4 * meta_count << " to " << i << std::endl;
 		}
 	}
 	//std::cout << mpi_rank << " finished posting meta receives" << std::endl;
-	size_list.clear();
 
 	// send meta data
 	for (int i = 0; i < slave_comm_size; i++) {
-		if (i != mpi_rank) {
-			std::vector<int> meta;
-			for (auto& target : target_source_map[i]) {
-				for (auto& source : target.second) {
-					// target domain id, source domain id, gr��e der richtigen Nachricht
-					meta.push_back(target.first);
-					meta.push_back(source.first);
-					meta.push_back(static_cast<int>(source.second.size()));
-					process_map[particle_type][i].insert(process_map[particle_type][i].end(), source.second.begin(), source.second.end());
-				}
-			}
+		if (isRemoteProcess(i)) {
+			std::vector<int> meta = buildRimMeta(particle_type, target_source_map, i);
 			//std::cout << mpi_rank << " trying to send meta " << meta.size() << " to " << i << std::endl;
 			MPI_Ssend(meta.data(), meta.size(), MPI_INT, i, META_RIM_TAG, slave_comm);
 		}
 	}
 
 	//std::cout << mpi_rank << " finished sending meta" << std::endl;
+	// meta_map is only complete once the meta receives are done
+	MPI_Waitall(static_cast<int>(meta_requests.size()), meta_requests.data(), MPI_STATUSES_IGNORE);
 	MPI_Barrier(slave_comm);
+	if (use_halo_codec) {
+		exchangeEncodedRimParticles(particle_type, meta_map);
+		MPI_Barrier(slave_comm);
+		return;
+	}
+
 	// post receive for particles
+	std::vector<MPI_Request> receive_requests;
 	for (auto& each_meta : meta_map) {
 		int process_id = each_meta.first;
-		if (process_id != mpi_rank) {
+		if (isRemoteProcess(process_id)) {
 			int meta_count = each_meta.second.size() / 3;
-			int total_count = 0;
+			long long total_count = 0;
 			for (int i = 0; i < meta_count; i++) {
 				int target = each_meta.second[i * 3];
 				int source = each_meta.second[1 + i * 3];
 				int count = each_meta.second[2 + i * 3];
 				total_count += count;
 			}
-			MPI_Request request;
 			incoming[particle_type][process_id] = std::vector<SphParticle>(total_count);
-			MPI_Irecv(incoming[particle_type][process_id].data(), total_count * sizeof(SphParticle), MPI_BYTE, process_id, RIM_TAG, slave_comm, &request);
+			postParticleReceives(incoming[particle_type][process_id].data(), total_count, process_id, RIM_TAG, slave_comm, receive_requests);
 			//std::cout << mpi_rank << " post receive Tag " << each_meta[3] << " for " << each_meta[4] << " to " << each_meta[0] << std::endl;
 		}
 	}
@@ -559,71 +905,258 @@ void SphManager::exchangeRimParticles(SphParticle::ParticleType particle_type) {
 	// send particles
 	
 	for (int i = 0; i < slave_comm_size; i++) {
-		if (i != mpi_rank) {
+		if (isRemoteProcess(i)) {
 			//std::cout << mpi_rank << " trying to send Tag " << count << " with " << source.second.size() << " to " << i << std::endl;
-			std::vector<SphParticle> send_particles;
-			for (auto& each_ptr : process_map[particle_type][i]) {
-				send_particles.push_back(*each_ptr);
+			if (process_map[particle_type][i].size() <= MAX_PARTICLES_PER_MESSAGE) {
+				MPI_Datatype rim_datatype = createRimDatatype(particle_type, i);
+				MPI_Ssend(MPI_BOTTOM, 1, rim_datatype, i, RIM_TAG, slave_comm);
+				MPI_Type_free(&rim_datatype);
+			}
+			else {
+				// the receiver expects the same split into messages as sendParticles does
+				std::vector<SphParticle>& send_particles = gatherRimParticles(particle_type, i);
+				sendParticles(send_particles.data(), static_cast<long long>(send_particles.size()), i, RIM_TAG, slave_comm, true);
 			}
-			MPI_Ssend(send_particles.data(), send_particles.size() * sizeof(SphParticle), MPI_BYTE, i, RIM_TAG, slave_comm);
 		}
 	}
+	MPI_Waitall(static_cast<int>(receive_requests.size()), receive_requests.data(), MPI_STATUSES_IGNORE);
 
 	//std::cout << mpi_rank << " finished sending particles" << std::endl;
 	MPI_Barrier(slave_comm);
+}
+
+void SphManager::exchangeEncodedRimParticles(SphParticle::ParticleType particle_type, std::unordered_map<int, std::vector<int>>& meta_map) {
+	HaloCodec& halo_codec = halo_codecs[particle_type];
+	halo_codec.beginExchange();
 
+	// messages too large for one request go through unencoded, both sides know from the meta data
+	std::vector<MPI_Request> receive_requests;
+	std::vector<int> encoded_sources;
 	for (auto& each_meta : meta_map) {
 		int process_id = each_meta.first;
-		if (process_id != mpi_rank) {
-			int meta_count = each_meta.second.size() / 3;
-			int total_count = 0;
-			for (int i = 0; i < meta_count; i++) {
-				int target = each_meta.second[i * 3];
-				int source = each_meta.second[1 + i * 3];
-				int count = each_meta.second[2 + i * 3];
-				for (int j = 0; j < count; j++) {
-					new_rim_particles[target][source].push_back(&incoming[particle_type][process_id][total_count + j]);
-				}
-				total_count += count;
+		if (isRemoteProcess(process_id)) {
+			long long total_count = 0;
+			for (int i = 2; i < each_meta.second.size(); i += 3) {
+				total_count += each_meta.second[i];
+			}
+			if (total_count == 0 || total_count > MAX_PARTICLES_PER_MESSAGE) {
+				halo_codec.forgetSource(process_id);
+			}
+			if (total_count > MAX_PARTICLES_PER_MESSAGE) {
+				incoming[particle_type][process_id] = std::vector<SphParticle>(total_count);
+				postParticleReceives(incoming[particle_type][process_id].data(), total_count, process_id, RIM_TAG, slave_comm, receive_requests);
+			}
+			else if (total_count != 0) {
+				encoded_sources.push_back(process_id);
 			}
 		}
 	}
 
-	//std::cout << mpi_rank << " finished building new map" << std::endl;
+	std::unordered_map<int, std::vector<char>> encoded_particles;
+	std::vector<MPI_Request> send_requests;
+	for (int i = 0; i < slave_comm_size; i++) {
+		if (isRemoteProcess(i)) {
+			std::vector<SphParticle*>& rim_particles = process_map[particle_type][i];
+			if (rim_particles.empty() || rim_particles.size() > MAX_PARTICLES_PER_MESSAGE) {
+				halo_codec.forgetTarget(i);
+			}
+			else {
+				halo_codec.encode(i, rim_particles, encoded_particles[i]);
+				send_requests.push_back(MPI_REQUEST_NULL);
+				MPI_Isend(encoded_particles[i].data(), static_cast<int>(encoded_particles[i].size()), MPI_BYTE, i, RIM_TAG, slave_comm, &send_requests.back());
+			}
+		}
+	}
+	for (int i = 0; i < slave_comm_size; i++) {
+		if (isRemoteProcess(i) && process_map[particle_type][i].size() > MAX_PARTICLES_PER_MESSAGE) {
+			std::vector<SphParticle>& send_particles = gatherRimParticles(particle_type, i);
+			sendParticles(send_particles.data(), static_cast<long long>(send_particles.size()), i, RIM_TAG, slave_comm, true);
+		}
+	}
 
-	for (auto& target : new_rim_particles) {
-		if (domains.count(target.first) != 0) {
-			getParticleDomain(target.first).addNeighbourRimParticles(target.second, particle_type);
+	for (int source : encoded_sources) {
+		MPI_Status status;
+		int byte_count;
+		MPI_Probe(source, RIM_TAG, slave_comm, &status);
+		MPI_Get_count(&status, MPI_BYTE, &byte_count);
+		std::vector<char> encoded(byte_count);
+		MPI_Recv(encoded.data(), byte_count, MPI_BYTE, source, RIM_TAG, slave_comm, MPI_STATUS_IGNORE);
+		halo_codec.decode(source, encoded, incoming[particle_type][source], particle_type);
+	}
+
+	MPI_Waitall(static_cast<int>(receive_requests.size()), receive_requests.data(), MPI_STATUSES_IGNORE);
+	MPI_Waitall(static_cast<int>(send_requests.size()), send_requests.data(), MPI_STATUSES_IGNORE);
+}
+
+void SphManager::exchangeRimParticlesPersistent(SphParticle::ParticleType particle_type,
+	std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>>& target_source_map,
+	std::unordered_map<int, std::vector<int>>& meta_map) {
+	std::unordered_map<int, std::vector<int>> outgoing_meta;
+	std::unordered_map<int, long long> outgoing_counts;
+
+	for (int i = 0; i < slave_comm_size; i++) {
+		if (isRemoteProcess(i) && target_source_map.count(i) != 0) {
+			outgoing_meta[i] = buildRimMeta(particle_type, target_source_map, i);
+			outgoing_counts[i] = static_cast<long long>(process_map[particle_type][i].size());
 		}
 	}
 
-	//std::cout << mpi_rank << " finished giving new map to domains" << std::endl;
+	HaloPlan& halo_plan = halo_plans[particle_type];
+	if (!halo_plan.prepare(outgoing_meta, outgoing_counts)) {
+		// rim messages have to be split, which the plan doesn't do
+		for (auto& each_target : outgoing_meta) {
+			process_map[particle_type].erase(each_target.first);
+		}
+		exchangeRimParticlesTwoSided(particle_type, target_source_map, meta_map);
+		return;
+	}
+
+	halo_plan.start(outgoing_meta);
+	std::vector<MPI_Request> send_requests;
+	std::vector<MPI_Datatype> rim_datatypes;
+	for (int target : halo_plan.getTargets()) {
+		rim_datatypes.push_back(createRimDatatype(particle_type, target));
+		send_requests.push_back(MPI_REQUEST_NULL);
+		MPI_Isend(MPI_BOTTOM, 1, rim_datatypes.back(), target, RIM_TAG, slave_comm, &send_requests.back());
+	}
+	halo_plan.finish(meta_map, incoming[particle_type]);
+	MPI_Waitall(static_cast<int>(send_requests.size()), send_requests.data(), MPI_STATUSES_IGNORE);
+	for (auto& each_datatype : rim_datatypes) {
+		MPI_Type_free(&each_datatype);
+	}
+}
+
+void SphManager::exchangeRimParticlesOneSided(SphParticle::ParticleType particle_type,
+	std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>>& target_source_map,
+	std::unordered_map<int, std::vector<int>>& meta_map) {
+	std::unordered_map<int, std::vector<int>> outgoing_meta;
+
+	for (int i = 0; i < slave_comm_size; i++) {
+		if (isRemoteProcess(i)) {
+			outgoing_meta[i] = buildRimMeta(particle_type, target_source_map, i);
+			gatherRimParticles(particle_type, i);
+		}
+	}
+
+	halo_window.exchange(outgoing_meta, send_buffers[particle_type], meta_map, incoming[particle_type]);
+}
+
+void SphManager::exchangeRimParticlesShared(SphParticle::ParticleType particle_type,
+	std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>>& target_source_map,
+	std::unordered_map<int, std::vector<int>>& meta_map, std::unordered_map<int, SphParticle*>& shared_particles) {
+	std::unordered_map<int, std::vector<int>> outgoing_meta;
+	std::unordered_map<int, std::vector<SphParticle*>> outgoing_particles;
+
+	for (auto& each_node_process : node_ranks) {
+		if (each_node_process.first != mpi_rank) {
+			outgoing_meta[each_node_process.second] = buildRimMeta(particle_type, target_source_map, each_node_process.first);
+			outgoing_particles[each_node_process.second] = process_map[particle_type][each_node_process.first];
+		}
+	}
+	shared_segments[particle_type].publish(node_comm, outgoing_meta, outgoing_particles);
+
+	for (auto& each_node_process : node_ranks) {
+		if (each_node_process.first != mpi_rank) {
+			SphParticle* particles;
+			shared_segments[particle_type].read(each_node_process.second, meta_map[each_node_process.first], particles);
+			shared_particles[each_node_process.first] = particles;
+		}
+	}
+}
+
+std::vector<int> SphManager::buildRimMeta(SphParticle::ParticleType particle_type,
+	std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>>& target_source_map, int process_id) {
+	std::vector<int> meta;
+	for (auto& target : target_source_map[process_id]) {
+		for (auto& source : target.second) {
+			// target domain id, source domain id, size of the particle message
+			meta.push_back(target.first);
+			meta.push_back(source.first);
+			meta.push_back(static_cast<int>(source.second.size()));
+			process_map[particle_type][process_id].insert(process_map[particle_type][process_id].end(), source.second.begin(), source.second.end());
+		}
+	}
+	return meta;
+}
+
+MPI_Datatype SphManager::createRimDatatype(SphParticle::ParticleType particle_type, int process_id) {
+	// the rim particles of a domain are partitioned into regions, so consecutive particles form one block
+	std::vector<int> block_lengths;
+	std::vector<MPI_Aint> displacements;
+	std::vector<SphParticle*>& rim_particles = process_map[particle_type][process_id];
+	for (int i = 0; i < rim_particles.size(); i++) {
+		if (i != 0 && rim_particles[i] == rim_particles[i - 1] + 1) {
+			block_lengths.back()++;
+		}
+		else {
+			MPI_Aint address;
+			MPI_Get_address(rim_particles[i], &address);
+			displacements.push_back(address);
+			block_lengths.push_back(1);
+		}
+	}
+
+	MPI_Datatype rim_datatype;
+	MPI_Type_create_hindexed(static_cast<int>(block_lengths.size()), block_lengths.data(), displacements.data(), getParticleDatatype(), &rim_datatype);
+	MPI_Type_commit(&rim_datatype);
+	return rim_datatype;
+}
+
+std::vector<SphParticle>& SphManager::gatherRimParticles(SphParticle::ParticleType particle_type, int process_id) {
+	std::vector<SphParticle>& send_particles = send_buffers[particle_type][process_id];
+	send_particles.clear();
+	for (auto& each_ptr : process_map[particle_type][process_id]) {
+		send_particles.push_back(*each_ptr);
+	}
+	return send_particles;
 }
 
 void SphManager::exchangeRimDensity(SphParticle::ParticleType particle_type) 
 {
-	MPI_Barrier(slave_comm);
 	std::unordered_map<int, std::vector<double>> incoming_densities;
-	for (int i = 0; i < slave_comm_size; i++) {
-		if (i != mpi_rank && !incoming[particle_type][i].empty()) {
-			MPI_Request request;
-			incoming_densities[i] = std::vector<double>(incoming[particle_type][i].size());
-			MPI_Irecv(incoming_densities[i].data(), incoming[particle_type][i].size(), MPI_DOUBLE, i, DENSITY_RIM_TAG, slave_comm, &request);
+
+	// processes on the same node read the densities in place
+	if (use_shared_memory) {
+		std::unordered_map<int, std::vector<SphParticle*>> outgoing_particles;
+		for (auto& each_node_process : node_ranks) {
+			if (each_node_process.first != mpi_rank) {
+				outgoing_particles[each_node_process.second] = process_map[particle_type][each_node_process.first];
+			}
 		}
+		shared_segments[particle_type].publishDensities(node_comm, outgoing_particles);
 	}
-	//std::cout << mpi_rank << " finished posting density receives" << std::endl;
-	MPI_Barrier(slave_comm);
-	for (int i = 0; i < slave_comm_size; i++) {
-		if (i != mpi_rank && !process_map[particle_type][i].empty()) {
-			std::vector<double> densities;
-			for (auto& each_ptr : process_map[particle_type][i]) {
-				densities.push_back(each_ptr->local_density);
+
+	if (halo_exchange_mode == ONE_SIDED) {
+		std::unordered_map<int, std::vector<double>> outgoing_densities;
+		for (int i = 0; i < slave_comm_size; i++) {
+			if (isRemoteProcess(i) && !process_map[particle_type][i].empty()) {
+				outgoing_densities[i] = gatherRimDensities(particle_type, i);
 			}
-			MPI_Ssend(densities.data(), process_map[particle_type][i].size(), MPI_DOUBLE, i, DENSITY_RIM_TAG, slave_comm);
 		}
+		halo_window.exchangeDensities(outgoing_densities, incoming_densities);
+	}
+	else {
+		MPI_Barrier(slave_comm);
+		std::vector<MPI_Request> receive_requests;
+		for (int i = 0; i < slave_comm_size; i++) {
+			if (isRemoteProcess(i) && !incoming[particle_type][i].empty()) {
+				incoming_densities[i] = std::vector<double>(incoming[particle_type][i].size());
+				receive_requests.emplace_back();
+				MPI_Irecv(incoming_densities[i].data(), incoming[particle_type][i].size(), MPI_DOUBLE, i, DENSITY_RIM_TAG, slave_comm, &receive_requests.back());
+			}
+		}
+		//std::cout << mpi_rank << " finished posting density receives" << std::endl;
+		MPI_Barrier(slave_comm);
+		for (int i = 0; i < slave_comm_size; i++) {
+			if (isRemoteProcess(i) && !process_map[particle_type][i].empty()) {
+				std::vector<double> densities = gatherRimDensities(particle_type, i);
+				MPI_Ssend(densities.data(), process_map[particle_type][i].size(), MPI_DOUBLE, i, DENSITY_RIM_TAG, slave_comm);
+			}
+		}
+		//std::cout << mpi_rank << " finished sending desnities" << std::endl;
+		MPI_Waitall(static_cast<int>(receive_requests.size()), receive_requests.data(), MPI_STATUSES_IGNORE);
+		MPI_Barrier(slave_comm);
 	}
-	//std::cout << mpi_rank << " finished sending desnities" << std::endl;
-	MPI_Barrier(slave_comm);
 
 	for (int i = 0; i < slave_comm_size; i++) {
 		if (i != mpi_rank) {
@@ -634,6 +1167,14 @@ void SphManager::exchangeRimDensity(SphParticle::ParticleType particle_type)
 	}
 }
 
+std::vector<double> SphManager::gatherRimDensities(SphParticle::ParticleType particle_type, int process_id) {
+	std::vector<double> densities;
+	for (auto& each_ptr : process_map[particle_type][process_id]) {
+		densities.push_back(each_ptr->local_density);
+	}
+	return densities;
+}
+
 void SphManager::spawnSourceParticles() {
 	if (sources.empty()) {
 		return;
@@ -652,34 +1193,243 @@ void SphManager::spawnSourceParticles() {
 	add_particles(new_particles);
 }
 
-void SphManager::exportParticles() {
-	std::vector<SphParticle> particles_to_export;
-	
+void SphManager::exportParticles(int simulation_timestep) {
+	if (export_mode == MPIIO_EXPORT) {
+		writeParticles(simulation_timestep);
+		return;
+	}
+	// nothing is gathered on timesteps without output, the master doesn't expect a frame then
+	if (!output_scheduler.isExportDue(simulation_timestep)) {
+		return;
+	}
+
+	// the slot of the frame exported export_queue_length frames ago, the simulation only waits if it is still in flight
+	int slot = export_slot;
+	export_slot = (export_slot + 1) % export_queue_length;
+	MPI_Waitall(static_cast<int>(export_requests[slot].size()), export_requests[slot].data(), MPI_STATUSES_IGNORE);
+	export_requests[slot].clear();
+
+	std::vector<SphParticle>& particles_to_export = export_buffers[slot];
+	particles_to_export.clear();
 	for (auto& each_domain : domains) {
 		if (each_domain.second.hasParticles(SphParticle::FLUID)) {
 			for (SphParticle& each_particle : each_domain.second.getFluidParticles()) { // change getParticles to getFluidParticles later
-				particles_to_export.push_back(each_particle);
+				if (output_scheduler.isExported(each_particle.position, each_particle.isSurface(), false, simulation_timestep)) {
+					particles_to_export.push_back(each_particle);
+				}
+			}
+		}
+	}
+	if (output_scheduler.isSurfaceDue(simulation_timestep)) {
+		std::vector<SphParticle> interior_cells;
+		collectInteriorCells(interior_cells);
+		for (SphParticle& each_cell : interior_cells) {
+			if (output_scheduler.isExported(each_cell.position, false, true, simulation_timestep)) {
+				particles_to_export.push_back(each_cell);
 			}
 		}
 	}
-
-	MPI_Barrier(MPI_COMM_WORLD);
 
 	//for (auto each_particle : particles_to_export) { std::cout << "export particle: " << each_particle << std::endl; } // debug 
 
 	// send number of particles to master
-	int number_of_particles_to_send = static_cast<int>(particles_to_export.size());
-	MPI_Send(&number_of_particles_to_send, 1, MPI_INT, 0, EXPORT_PARTICLES_NUMBER_TAG, MPI_COMM_WORLD);
+	export_counts[slot] = static_cast<long long>(particles_to_export.size());
+	export_requests[slot].emplace_back();
+	MPI_Isend(&export_counts[slot], 1, MPI_LONG_LONG, 0, EXPORT_PARTICLES_NUMBER_TAG, MPI_COMM_WORLD, &export_requests[slot].back());
 
 	//send particles to master
-	if (number_of_particles_to_send != 0) {
-		MPI_Send(particles_to_export.data(), number_of_particles_to_send * sizeof(SphParticle), MPI_BYTE, 0, EXPORT_TAG, MPI_COMM_WORLD);
+	if (export_counts[slot] != 0) {
+		postParticleSends(particles_to_export.data(), export_counts[slot], 0, EXPORT_TAG, MPI_COMM_WORLD, export_requests[slot]);
+	}
+}
+
+void SphManager::writeParticles(int simulation_timestep) {
+	std::vector<SphParticle>& particles_to_write = export_buffers[0];
+	if (output_scheduler.isDue(OutputScheduler::FRAME_STREAM, simulation_timestep)) {
+		collectFluidParticles(OutputScheduler::FRAME_STREAM, particles_to_write);
+		particle_writer.writeFrame(particles_to_write, simulation_timestep);
+	}
+
+	// without the master vtk output is only written as vtu pieces
+	if (vtk_format == VTU_VTK && output_scheduler.isDue(OutputScheduler::VTK_STREAM, simulation_timestep)) {
+		int fields = output_scheduler.getFields(OutputScheduler::VTK_STREAM);
+		std::string name = "particles_" + std::to_string(simulation_timestep);
+		collectFluidParticles(OutputScheduler::VTK_STREAM, particles_to_write);
+		ParticleIO::exportPieceToVTU(particles_to_write.data(), particles_to_write.size(), "vtk/" + name + "_" + std::to_string(mpi_rank) + ".vtu", mpi_rank, fields);
+
+		if (mpi_rank == 0) {
+			std::vector<std::string> pieces;
+			for (int i = 0; i < slave_comm_size; i++) {
+				pieces.push_back(name + "_" + std::to_string(i) + ".vtu");
+			}
+			ParticleIO::exportPVTU("vtk/" + name + ".pvtu", pieces, fields);
+			vtk_time_series.emplace_back(simulation_timestep * TIMESTEP_DURATION, name + ".pvtu");
+		}
+	}
+}
+
+void SphManager::collectFluidParticles(OutputScheduler::Stream stream, std::vector<SphParticle>& particles) {
+	particles.clear();
+	for (auto& each_domain : domains) {
+		if (each_domain.second.hasParticles(SphParticle::FLUID)) {
+			for (SphParticle& each_particle : each_domain.second.getFluidParticles()) {
+				if (output_scheduler.isInRegion(stream, each_particle.position) && output_scheduler.isInContent(stream, each_particle.isSurface(), false)) {
+					particles.push_back(each_particle);
+				}
+			}
+		}
+	}
+	if (output_scheduler.getContent(stream) == OutputScheduler::SURFACE_PARTICLES) {
+		std::vector<SphParticle> interior_cells;
+		collectInteriorCells(interior_cells);
+		for (SphParticle& each_cell : interior_cells) {
+			if (output_scheduler.isInRegion(stream, each_cell.position)) {
+				particles.push_back(each_cell);
+			}
+		}
+	}
+}
+
+void SphManager::collectInteriorCells(std::vector<SphParticle>& cells) {
+	// one particle per neighbour search cell at the centre of mass of its interior particles, with their mass and mean velocity.
+	// Its density is the mass per cell volume
+	std::unordered_map<int, SphParticle> interior_cells;
+	for (auto& each_domain : domains) {
+		if (each_domain.second.hasParticles(SphParticle::FLUID)) {
+			for (SphParticle& each_particle : each_domain.second.getFluidParticles()) {
+				if (!each_particle.isSurface()) {
+					int cell_id = computeDomainID(each_particle.position, cell_dimensions);
+					SphParticle& cell = interior_cells.emplace(cell_id, SphParticle(Vector3(), Vector3(), 0.0)).first->second;
+					cell.position += each_particle.mass * each_particle.position;
+					cell.velocity += each_particle.mass * each_particle.velocity;
+					cell.mass += each_particle.mass;
+				}
+			}
+		}
+	}
+
+	double cell_volume = cell_dimensions.x * cell_dimensions.y * cell_dimensions.z;
+	for (auto& each_cell : interior_cells) {
+		SphParticle& cell = each_cell.second;
+		cell.position = cell.position / cell.mass;
+		cell.velocity = cell.velocity / cell.mass;
+		cell.local_density = cell.mass / cell_volume;
+		cell.id = INTERIOR_CELL_ID_FLAG | static_cast<unsigned int>(each_cell.first);
+		cell.setSurface(false);
+		cells.push_back(cell);
+	}
+}
+
+void SphManager::writeStatistics(int simulation_timestep) {
+	// particle count, speed sum, density sum, kinetic energy
+	double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+	double max_speed = 0.0;
+	for (auto& each_domain : domains) {
+		if (each_domain.second.hasParticles(SphParticle::FLUID)) {
+			for (SphParticle& each_particle : each_domain.second.getFluidParticles()) {
+				if (output_scheduler.isInRegion(OutputScheduler::STATISTICS_STREAM, each_particle.position)) {
+					double speed = each_particle.velocity.length();
+					sums[0] += 1.0;
+					sums[1] += speed;
+					sums[2] += each_particle.local_density;
+					sums[3] += 0.5 * each_particle.mass * speed * speed;
+					max_speed = std::max(max_speed, speed);
+				}
+			}
+		}
+	}
+
+	double total_sums[4];
+	double total_max_speed;
+	MPI_Reduce(sums, total_sums, 4, MPI_DOUBLE, MPI_SUM, 0, slave_comm);
+	MPI_Reduce(&max_speed, &total_max_speed, 1, MPI_DOUBLE, MPI_MAX, 0, slave_comm);
+
+	if (mpi_rank == 0) {
+		double particle_count = std::max(total_sums[0], 1.0);
+		std::ofstream statistics_file("statistics.csv", std::ios::app);
+		statistics_file << simulation_timestep << "," << simulation_timestep * TIMESTEP_DURATION << "," << static_cast<long long>(total_sums[0]) << ","
+			<< total_sums[1] / particle_count << "," << total_max_speed << "," << total_sums[2] / particle_count << "," << total_sums[3] << "\n";
+	}
+}
+
+void SphManager::waitForExports() {
+	for (auto& each_requests : export_requests) {
+		MPI_Waitall(static_cast<int>(each_requests.size()), each_requests.data(), MPI_STATUSES_IGNORE);
+		each_requests.clear();
+	}
+}
+
+bool SphManager::isCheckpointDue(int simulation_timestep) {
+	// every slave has to take part, even if only one of them got the signal
+	int is_requested = checkpoint_requested;
+	int is_requested_anywhere;
+	MPI_Allreduce(&is_requested, &is_requested_anywhere, 1, MPI_INT, MPI_MAX, slave_comm);
+	if (is_requested) {
+		checkpoint_requested = 0;
+	}
+	return is_requested_anywhere != 0 || output_scheduler.isDue(OutputScheduler::CHECKPOINT_STREAM, simulation_timestep);
+}
+
+void SphManager::writeCheckpoint(int simulation_timestep) {
+	std::vector<SphParticle> particles;
+	for (auto& each_domain : domains) {
+		for (SphParticle* each_particle : each_domain.second.getParticles()) {
+			particles.push_back(*each_particle);
+		}
+	}
+
+	CheckpointState state;
+	state.timestep = simulation_timestep;
+	state.sink_height = sink_height;
+	state.shutter_timestep = shutter_timestep;
+	state.particle_id_count = particle_id_count;
+	state.sources = sources;
+	checkpoint_writer.write(slave_comm, "sph.chkp", state, particles);
+	if (mpi_rank == 0) {
+		std::cout << "writing checkpoint of timestep " << simulation_timestep << std::endl;
+	}
+}
+
+bool SphManager::restart(std::string fileName) {
+	MPI_Comm_rank(slave_comm, &mpi_rank);
+	CheckpointState state;
+	std::vector<SphParticle> particles;
+	if (!CheckpointReader::read(slave_comm, fileName, state, particles)) {
+		return false;
+	}
+
+	cleanUpAllParticles();
+	for (auto& each_target : add_particles_map) {
+		each_target.second.clear();
+	}
+	sink_height = state.sink_height;
+	shutter_timestep = static_cast<int>(state.shutter_timestep);
+	// like addsource every process keeps the sources inside its own domains
+	sources.clear();
+	for (const Vector3& each_source : state.sources) {
+		if (computeProcessID(each_source, domain_dimensions) == mpi_rank) {
+			sources.push_back(each_source);
+		}
 	}
+	first_timestep = static_cast<int>(state.timestep) + 1;
+	// the ids of the checkpoint stay, new ones continue after the largest counter of any process that wrote it
+	particle_id_count = state.particle_id_count;
+	// the exchange at the start of the simulation hands them to the process owning their domain
+	add_particles(particles);
+	return true;
+}
 
+void SphManager::requestCheckpoint(int) {
+	checkpoint_requested = 1;
 }
 
 void SphManager::add_particles(const std::vector<SphParticle>& new_particles) {
 	for (SphParticle particle : new_particles) {
+		// created on this process, particles keep their id through migration, halos and export
+		if (particle.id == 0) {
+			particle_id_count++;
+			particle.id = (static_cast<unsigned long long>(mpi_rank + 1) << PARTICLE_ID_RANK_SHIFT) | particle_id_count;
+		}
 		int domain_id = computeDomainID(particle.position, domain_dimensions);
 		int process_id = computeProcessID(domain_id);
 
@@ -715,11 +1465,114 @@ void SphManager::addSource(const Vector3& source) {
 	sources.push_back(source);
 }
 
+void SphManager::setHaloExchangeMode(HaloExchangeMode halo_exchange_mode) {
+	this->halo_exchange_mode = halo_exchange_mode;
+}
+
+void SphManager::setSharedMemoryExchange(bool use_shared_memory) {
+	this->use_shared_memory = use_shared_memory;
+}
+
+void SphManager::setHaloCodec(bool use_halo_codec) {
+	this->use_halo_codec = use_halo_codec;
+}
+
+void SphManager::setExportMode(ExportMode export_mode) {
+	this->export_mode = export_mode;
+}
+
+SphManager::ExportMode SphManager::getExportMode() const {
+	return export_mode;
+}
+
+void SphManager::setExportQueueLength(int export_queue_length) {
+	this->export_queue_length = export_queue_length;
+}
+
+int SphManager::getExportQueueLength() const {
+	return export_queue_length;
+}
+
+void SphManager::setFrameFormat(FrameFormat frame_format) {
+	this->frame_format = frame_format;
+}
+
+SphManager::FrameFormat SphManager::getFrameFormat() const {
+	return frame_format;
+}
+
+void SphManager::setFrameTolerance(double frame_tolerance) {
+	this->frame_tolerance = frame_tolerance;
+}
+
+void SphManager::setFrameIds(bool use_frame_ids) {
+	this->use_frame_ids = use_frame_ids;
+}
+
+bool SphManager::getFrameIds() const {
+	return use_frame_ids;
+}
+
+double SphManager::getFrameTolerance() const {
+	return frame_tolerance;
+}
+
+void SphManager::setVtkFormat(VtkFormat vtk_format) {
+	this->vtk_format = vtk_format;
+}
+
+SphManager::VtkFormat SphManager::getVtkFormat() const {
+	return vtk_format;
+}
+
+OutputScheduler& SphManager::getOutputScheduler() {
+	return output_scheduler;
+}
+
+void SphManager::setDensityMode(DensityMode density_mode) {
+	this->density_mode = density_mode;
+}
+
+void SphManager::setDoubleGhostLayer(bool use_double_ghost_layer) {
+	this->use_double_ghost_layer = use_double_ghost_layer;
+}
+
+void SphManager::setBlockSize(int cells_per_block) {
+	domain_dimensions = cell_dimensions * cells_per_block;
+	// the master owns no domains, it only needs the dimensions
+	if (slave_comm == MPI_COMM_NULL) {
+		return;
+	}
+
+	// collect all particles of this process, they belong to different domains afterwards
+	std::vector<SphParticle> all_particles;
+	for (auto& each_domain : domains) {
+		for (auto& each_particle : each_domain.second.getParticles()) {
+			all_particles.push_back(*each_particle);
+		}
+	}
+	for (auto& each_process : add_particles_map) {
+		all_particles.insert(all_particles.end(), each_process.second.begin(), each_process.second.end());
+		each_process.second.clear();
+	}
+	domains.clear();
+
+	add_particles(all_particles);
+}
+
 void SphManager::setShutterTimestep(int shutter_timestep)
 {
 	this->shutter_timestep = shutter_timestep;
 }
 
+void SphManager::setFirstTimestep(int first_timestep) {
+	this->first_timestep = first_timestep;
+}
+
+int SphManager::getFirstTimestep() const {
+	return first_timestep;
+}
+
 const Vector3& SphManager::getDomainDimensions() const {
 	return domain_dimensions;
 }
@@ -3,6 +3,16 @@
 #include "SphKernelFactory.h"
 #include "SphNeighbourSearchFactory.h"
 #include "SimulationUtilities.h"
+#include "HaloWindow.h"
+#include "HaloPlan.h"
+#include "HaloCodec.h"
+#include "SharedHaloSegment.h"
+#include "ProgressThread.h"
+#include "OutputScheduler.h"
+#include "../data/ParallelParticleWriter.h"
+#include "../data/CheckpointWriter.h"
+#include "../data/CheckpointReader.h"
+#include "../data/ParticleIO.h"
 
 #include <vector>
 #include <array>
@@ -10,35 +20,147 @@
 #include <iterator>
 #include <random>
 #include <functional>
+#include <fstream>
+#include <csignal>
 
 class SphManager {
 public:
+	enum HaloExchangeMode
+	{
+		TWO_SIDED,
+		ONE_SIDED,
+		PERSISTENT
+	};
+
+	enum ExportMode
+	{
+		MASTER_EXPORT,
+		MPIIO_EXPORT
+	};
+
+	enum FrameFormat
+	{
+		TEXT_FRAMES,
+		BINARY_FRAMES,
+		COMPRESSED_FRAMES
+	};
+
+	enum VtkFormat
+	{
+		LEGACY_VTK,
+		VTU_VTK
+	};
+
+	enum DensityMode
+	{
+		SUMMATION_DENSITY,
+		CONTINUITY_DENSITY
+	};
+
 	SphManager();
 	SphManager(const Vector3&);
 	~SphManager();
 
 	void simulate(int number_of_timesteps);
+	// collective on the slaves, replaces all particles and the sources, sink and shutter with those of the checkpoint.
+	// The next simulation continues after the timestep of the checkpoint
+	bool restart(std::string fileName);
+	// signal handler, the slaves write a checkpoint after the timestep they are in
+	static void requestCheckpoint(int);
 	void add_particles(const std::vector<SphParticle>&);
-	void exportParticles();
+	void exportParticles(int simulation_timestep);
 	void setSink(const double&);
 	void addSource(const Vector3&);
 	void setShutterTimestep(int shutter_timestep);
+	void setFirstTimestep(int first_timestep);
+	int getFirstTimestep() const;
+	void setHaloExchangeMode(HaloExchangeMode);
+	void setSharedMemoryExchange(bool);
+	void setBlockSize(int);
+	void setDoubleGhostLayer(bool);
+	void setDensityMode(DensityMode);
+	void setHaloCodec(bool);
+	void setExportMode(ExportMode);
+	ExportMode getExportMode() const;
+	void setExportQueueLength(int);
+	int getExportQueueLength() const;
+	void setFrameFormat(FrameFormat);
+	FrameFormat getFrameFormat() const;
+	void setFrameTolerance(double);
+	double getFrameTolerance() const;
+	void setFrameIds(bool);
+	bool getFrameIds() const;
+	void setVtkFormat(VtkFormat);
+	VtkFormat getVtkFormat() const;
+	OutputScheduler& getOutputScheduler();
 	const Vector3& getDomainDimensions() const;
 
 private:
 	int mpi_rank;
+	// a domain is the unit of process ownership, it spans a cube of neighbour search cells
 	Vector3 domain_dimensions;
+	Vector3 cell_dimensions;
 	double sink_height;
 	double half_timestep_duration;
 	Vector3 const gravity_acceleration;
 	int shutter_timestep;
+	HaloExchangeMode halo_exchange_mode;
+	bool use_shared_memory;
+	// rim of 2 * Q_MAX, densities of the first ghost layer are computed locally instead of exchanged
+	bool use_double_ghost_layer;
+	// continuity integrates the densities and only sums them up every DENSITY_REINITIALIZATION_INTERVAL timesteps
+	DensityMode density_mode;
+	// two-sided rim messages carry particle ids and quantised deltas
+	bool use_halo_codec;
+	OutputScheduler output_scheduler;
+	// the slaves write sph.pbin themselves instead of sending every frame to the master
+	ExportMode export_mode;
+	ParallelParticleWriter particle_writer;
+	// frames that are still being sent to the master, one slot per frame in flight
+	int export_queue_length;
+	int export_slot;
+	std::vector<std::vector<SphParticle>> export_buffers;
+	std::vector<long long> export_counts;
+	std::vector<std::vector<MPI_Request>> export_requests;
+	// the master writes sph.ptcl as text, sph.pfrm in the binary frame format or sph.pcmp compressed
+	FrameFormat frame_format;
+	// error of compressed frames relative to the bounding box of a frame
+	double frame_tolerance;
+	// text and binary frames carry the particle ids
+	bool use_frame_ids;
+	// ascii legacy vtk files or binary vtu pieces per process, which the slaves write themselves in mpiio mode
+	VtkFormat vtk_format;
+	// time and pvtu file of every vtu frame written by the slaves
+	std::vector<std::pair<double, std::string>> vtk_time_series;
+	// particles given an id by this process
+	unsigned long long particle_id_count;
+	// timestep the next simulation starts at, after the timestep of a loaded checkpoint
+	int first_timestep;
+	// writes sph.chkp while the simulation continues
+	CheckpointWriter checkpoint_writer;
 
 	std::unordered_map<int, ParticleDomain> domains;
 	std::unordered_map<int, std::vector<SphParticle>> add_particles_map;
 	std::unordered_map<SphParticle::ParticleType, std::unordered_map<int, std::vector<SphParticle*>>> process_map;
 	std::unordered_map<SphParticle::ParticleType, std::unordered_map<int, std::vector<SphParticle>>> incoming;
+	// contiguous rim particles per target process, reused every timestep
+	std::unordered_map<SphParticle::ParticleType, std::unordered_map<int, std::vector<SphParticle>>> send_buffers;
 	std::vector<std::vector<SphParticle*>> neighbour_particles;
+	std::vector<SphParticle*> ghost_particles;
+	std::vector<std::vector<SphParticle*>> ghost_neighbour_particles;
 	std::vector<Vector3> sources;
+	HaloWindow halo_window;
+	std::unordered_map<SphParticle::ParticleType, HaloPlan> halo_plans;
+	std::unordered_map<SphParticle::ParticleType, HaloCodec> halo_codecs;
+
+	// processes on the same node, slave rank -> node rank
+	MPI_Comm node_comm;
+	std::unordered_map<int, int> node_ranks;
+	std::unordered_map<SphParticle::ParticleType, SharedHaloSegment> shared_segments;
+	SharedHaloSegment migration_segment;
+
+	// only exists during a simulation and if enabled at startup
+	ProgressThread* progress_thread;
 
 	ISphKernel* kernel;
 	ISphNeighbourSearch* neighbour_search;
@@ -51,20 +173,50 @@ private:
 	void cleanUpShutterParticles();
 
 	std::vector<SphParticle> getNeighbours(int);
-	void update();
+	void update(int simulation_timestep);
+	void computeDensities();
+	void findGhostNeighbours(ParticleDomain&, std::unordered_map<int, std::vector<SphParticle*>>&);
 	bool updateVelocity(SphParticle&, std::vector<SphParticle>&);
 	Vector3 correctVelocity(SphParticle&, Vector3&, std::vector<SphParticle>&);
 	Vector3 computeAcceleration(SphParticle&, std::vector<SphParticle>&);
 	Vector3 computeDensityAcceleration(SphParticle&, std::vector<SphParticle>&);
 	Vector3 computeViscosityAcceleration(SphParticle&, std::vector<SphParticle>&);
 	void computeLocalDensity(SphParticle&, std::vector<SphParticle>&);
+	double computeDensityRate(SphParticle&, std::vector<SphParticle>&);
 	void filterLocalDensity(SphParticle&, std::vector<SphParticle>&);
 	double computeLocalPressure(SphParticle&);
+	void classifySurface(SphParticle&, std::vector<SphParticle>&);
+
+	void createNodeCommunicator();
+	void freeNodeCommunicator();
+	bool isRemoteProcess(int);
 
 	void exchangeParticles();
+	void exchangeParticlesShared(std::unordered_map<int, std::vector<SphParticle>>&, std::vector<std::vector<SphParticle>>&);
 	void exchangeRimParticles(SphParticle::ParticleType);
+	void exchangeRimParticlesTwoSided(SphParticle::ParticleType,
+		std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>>&, std::unordered_map<int, std::vector<int>>&);
+	void exchangeEncodedRimParticles(SphParticle::ParticleType, std::unordered_map<int, std::vector<int>>&);
+	void exchangeRimParticlesPersistent(SphParticle::ParticleType,
+		std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>>&, std::unordered_map<int, std::vector<int>>&);
+	void exchangeRimParticlesOneSided(SphParticle::ParticleType,
+		std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>>&, std::unordered_map<int, std::vector<int>>&);
+	void exchangeRimParticlesShared(SphParticle::ParticleType,
+		std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>>&, std::unordered_map<int, std::vector<int>>&,
+		std::unordered_map<int, SphParticle*>&);
+	std::vector<int> buildRimMeta(SphParticle::ParticleType, std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<SphParticle*>>>>&, int);
+	MPI_Datatype createRimDatatype(SphParticle::ParticleType, int);
+	std::vector<SphParticle>& gatherRimParticles(SphParticle::ParticleType, int);
 	void exchangeRimDensity(SphParticle::ParticleType);
+	std::vector<double> gatherRimDensities(SphParticle::ParticleType, int);
 	void spawnSourceParticles();
+	void writeParticles(int simulation_timestep);
+	void collectFluidParticles(OutputScheduler::Stream, std::vector<SphParticle>&);
+	void collectInteriorCells(std::vector<SphParticle>&);
+	void waitForExports();
+	void writeStatistics(int simulation_timestep);
+	bool isCheckpointDue(int simulation_timestep);
+	void writeCheckpoint(int simulation_timestep);
 
 	ParticleDomain& getParticleDomain(const int&);
 	ParticleDomain& getParticleDomain(const Vector3&);
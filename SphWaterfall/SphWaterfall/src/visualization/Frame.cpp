@@ -16,7 +16,12 @@ Frame::Frame(unsigned int width, unsigned int height) {
 }
 
 Pixel& Frame::getPixel(unsigned int x, unsigned int y) {
-	if (x >= this->width || y >= this->height) return Pixel(0, 0, 0);
+	// reads outside of the frame get a fresh black pixel, writes to it are lost with the next such read
+	static Pixel out_of_frame = Pixel(0, 0, 0);
+	if (x >= this->width || y >= this->height) {
+		out_of_frame = Pixel(0, 0, 0);
+		return out_of_frame;
+	}
 	return pixels.at(y*width + x);
 }
 
@@ -35,13 +35,20 @@ void VisualizationManager::renderFrames(string inputFileName) {
 		cout << "Please initialize the VisualizationManager before rendering!\n";
 	}
 
-	vector<vector<SphParticle>> frameParticles = ParticleIO::importParticles(inputFileName);
+	//Frames are read one at a time while the previous one is rendered
+	FrameStream frameStream;
+	if (!frameStream.open(inputFileName)) {
+		return;
+	}
 
-	for (int g = 0; g < frameParticles.size(); g++) {
+	vector<SphParticle> frameParticles;
+	while (frameStream.next(frameParticles)) {
+		int g = frameStream.getFrameIndex();
 		cout << "Rendering Frame #" << g << "\n";
-		vector<ParticleObject> frame = convertFluidParticles(frameParticles.at(g));
+		vector<ParticleObject> frame = convertFluidParticles(frameParticles);
 
-		Frame f = camera.renderFrame(frame, g);
+		//The shutter is switched by the timestep the frame was written at, not by its position in the file
+		Frame f = camera.renderFrame(frame, static_cast<int>(frameStream.getFrameNumber()));
 
 		writeFrameToBitmap(f, (("output/frame_" + std::to_string(g)) + ".bmp").c_str(), f.getWidth(), f.getHeight());
 	}
@@ -55,69 +62,63 @@ void VisualizationManager::renderFramesDistributed(string inputFileName, int ran
 	int world_size;
 	MPI_Comm_size(MPI_COMM_WORLD, &world_size);
 
-	if (rank == 0) {
-		//Send frame count
-		vector<vector<SphParticle>> frameParticles = ParticleIO::importParticles(inputFileName);
-		for (int i = 1; i < world_size; i++) {
-			unsigned int buf[1] =
-			{
-				static_cast<unsigned int>(frameParticles.size())
-			};
-			MPI_Send(buf, 1, MPI_UNSIGNED, i, 0, MPI_COMM_WORLD);
-		}
+	//Every processor reads its frames itself, the master only hands out frame numbers
+	IndexedFrameReader frameReader;
+	long long frameInfo[2] = { 0, 0 };
+	vector<long long> frameOffsets;
+	if (rank == 0 && frameReader.open(inputFileName)) {
+		frameInfo[0] = static_cast<long long>(frameReader.getFrameCount());
+		frameInfo[1] = frameReader.hasFrameTable() ? 1 : 0;
+		frameOffsets = frameReader.getFrameOffsets();
+	}
+
+	//Share frame count and the offsets of a text file, so it is only scanned once
+	MPI_Bcast(frameInfo, 2, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+	unsigned int frameCount = static_cast<unsigned int>(frameInfo[0]);
+	if (frameInfo[1] == 0) {
+		frameOffsets.resize(frameCount);
+		MPI_Bcast(frameOffsets.data(), frameCount, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+	}
 
-		//Send Frames distributed to all other processors
-		for (int g = 0; g < frameParticles.size(); g++) {
-				int target = (g % (world_size - 1)) + 1;
-				vector<ParticleObject> frame = convertFluidParticles(frameParticles.at(g));
-
-				//Send frame size
-				unsigned int buf[1] =
-				{
-					static_cast<unsigned int>(frame.size())
-				};
-				MPI_Send(buf, 1, MPI_UNSIGNED, target, 0, MPI_COMM_WORLD);
-
-				for (int i = 0; i < frame.size(); i++) {
-					ParticleObject::MpiSendPObject(frame[i], target);
-				}
+	if (rank == 0) {
+		//Hand out the next frame to whichever processor asks first, then the end marker to everyone
+		for (unsigned int g = 0; g < frameCount + world_size - 1; g++) {
+			int request;
+			MPI_Status status;
+			MPI_Recv(&request, 1, MPI_INT, MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, &status);
+
+			unsigned int frameNumber = (g < frameCount) ? g : END_OF_FRAMES;
+			MPI_Send(&frameNumber, 1, MPI_UNSIGNED, status.MPI_SOURCE, 0, MPI_COMM_WORLD);
 		}
 	}
 	else {
-		//Receive Frame count
-		unsigned int buf[1];
-		MPI_Recv(buf, 1, MPI_UNSIGNED, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-		int frameCount = buf[0];
-
-		vector<vector<ParticleObject>> frameParticles;
-
-		//Receive Frames from master
-		for (int g = 0; g < frameCount; g++) {
-			if ((g % (world_size - 1)) + 1 == rank) {
-				unsigned int frameSize[1];
-				MPI_Recv(frameSize, 1, MPI_UNSIGNED, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-				vector<ParticleObject> frame;
-				for (int i = 0; i < frameSize[0]; i++) {
-					frame.emplace_back(ParticleObject::MpiReceivePObject(0));
-				}
-				frameParticles.emplace_back(frame);
+		if (frameCount != 0) {
+			if (frameInfo[1] == 1) {
+				frameReader.open(inputFileName);
+			}
+			else {
+				frameReader.open(inputFileName, frameOffsets);
 			}
 		}
 
-		int counter = 0;
+		//Ask for a frame, read it from the file and render it until no frames are left
+		vector<SphParticle> frameParticles;
+		while (true) {
+			MPI_Send(&rank, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
+			unsigned int i;
+			MPI_Recv(&i, 1, MPI_UNSIGNED, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			if (i == END_OF_FRAMES) {
+				break;
+			}
 
-		//Render frames and save to disk
-		for (int i = 0; i < frameCount; i++) {
-			if ((i % (world_size - 1)) + 1 == rank) {
-				if (counter >= frameParticles.size()) continue;
-				vector<ParticleObject> frame = frameParticles.at(counter);
+			frameReader.readFrame(i, frameParticles);
+			vector<ParticleObject> frame = convertFluidParticles(frameParticles);
 
-				Frame f = camera.renderFrame(frame, i);
+			//The shutter is switched by the timestep the frame was written at, not by its position in the file
+			Frame f = camera.renderFrame(frame, static_cast<int>(frameReader.getFrameNumber(i)));
 
-				writeFrameToBitmap(f, (("output/frame_" + std::to_string(i)) + ".bmp").c_str(), f.getWidth(), f.getHeight());
-				std::cout << "Frame " << i+1 << "/" << frameCount << " finished on Processor " << rank << "." << std::endl;
-				counter++;
-			}
+			writeFrameToBitmap(f, (("output/frame_" + std::to_string(i)) + ".bmp").c_str(), f.getWidth(), f.getHeight());
+			std::cout << "Frame " << i+1 << "/" << frameCount << " finished on Processor " << rank << "." << std::endl;
 		}
 	}
 }
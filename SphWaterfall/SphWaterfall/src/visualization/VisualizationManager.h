@@ -4,8 +4,13 @@
 #include "util.h"
 #include "../data/SphParticle.h"
 #include "../data/ParticleIO.h"
+#include "../data/FrameStream.h"
+#include "../data/IndexedFrameReader.h"
 #include <string>
 
+//Markiert das Ende der Frames beim verteilten Rendern
+#define END_OF_FRAMES 0xFFFFFFFFu
+
 
 class VisualizationManager {
 public:
@@ -24,7 +29,7 @@ public:
 	//Rendert Frames
 	static void renderFrames(string inputFileName);
 
-	//Rendert Frames mit MPI
+	//Rendert Frames mit MPI, jeder Prozess liest die ihm zugeteilten Frames selbst aus der Datei
 	static void renderFramesDistributed(string inputFileName, int rank);
 
 	//Generiert Test Frames mit zufaelligen Partikeln